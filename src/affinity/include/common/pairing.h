@@ -0,0 +1,82 @@
+#pragma once
+
+#include <mpi.h>
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "common/mpi.h"
+
+/**
+ * @brief Writer/reader pairing of the ranks of a job
+ *
+ * Every rank drives its own GPU and NIC and is paired with exactly one peer:
+ *
+ * - node: local rank l of an even node writes to local rank l of the next
+ *   node, so every NIC of a node is busy at once (needs an even node count).
+ * - half: rank r of the first half of the job writes to rank r + size / 2,
+ *   which also works inside a single node.
+ *
+ * Ranks are assumed to be laid out by node, as MPI::GetNodeIndex() does.
+ */
+struct Pairing {
+  enum Role { kWriter, kReader };
+
+  int peer;   ///< world rank of the peer
+  Role role;  ///< role of this rank
+
+  /**
+   * @brief Pair this rank
+   * @param pattern node or half
+   * @return Peer and role of this rank
+   * @throws std::invalid_argument for an unknown pattern or a job that cannot be paired
+   */
+  inline static Pairing Get(const std::string &pattern) {
+    auto &mpi = MPI::Get();
+    auto rank = mpi.GetWorldRank();
+    auto size = mpi.GetWorldSize();
+    if (pattern == "node") {
+      auto node = mpi.GetNodeIndex(), local = mpi.GetLocalSize();
+      if (mpi.GetNumNodes() % 2 or size % local) throw std::invalid_argument("node pairing needs an even number of equally sized nodes");
+      return node % 2 == 0 ? Pairing{rank + local, kWriter} : Pairing{rank - local, kReader};
+    }
+    if (pattern == "half") {
+      if (size % 2) throw std::invalid_argument("half pairing needs an even number of ranks");
+      return rank < size / 2 ? Pairing{rank + size / 2, kWriter} : Pairing{rank - size / 2, kReader};
+    }
+    throw std::invalid_argument(fmt::format("unknown pairing {}", pattern));
+  }
+};
+
+/**
+ * @brief Gather every writer's bandwidth on rank 0 and print it per rank and per node
+ *
+ * Collective over MPI_COMM_WORLD; readers pass 0. The per-node sum shows
+ * whether all NICs of a node saturate at the same time.
+ *
+ * @param gbps Bandwidth of this rank in Gbps
+ */
+inline void ReportBandwidth(double gbps) {
+  auto &mpi = MPI::Get();
+  auto size = mpi.GetWorldSize(), local = mpi.GetLocalSize();
+  std::vector<double> all(size, 0);
+  MPI_Gather(&gbps, 1, MPI_DOUBLE, all.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  if (mpi.GetWorldRank() != 0) return;
+
+  std::cout << fmt::format("\n{:>6} {:>6} {:>6} {:>12}", "rank", "node", "local", "bw(Gbps)") << std::endl;
+  for (int r = 0; r < size; ++r) {
+    if (all[r] > 0) std::cout << fmt::format("{:>6} {:>6} {:>6} {:>12.3f}", r, r / local, r % local, all[r]) << std::endl;
+  }
+  for (int n = 0; n < size / local; ++n) {
+    double sum = 0;
+    int writers = 0;
+    for (int r = n * local; r < (n + 1) * local; ++r) {
+      sum += all[r];
+      writers += all[r] > 0;
+    }
+    if (writers) std::cout << fmt::format("node {}: writers={} aggregate={:.3f}Gbps", n, writers, sum) << std::endl;
+  }
+}
@@ -12,10 +12,10 @@ class Progress {
   inline constexpr static double Gb = 8.0f / 1e9;
 
   Progress() = default;
-  Progress(size_t total_ops, size_t total_bw) : total_ops_{total_ops}, total_bw_{total_bw} {}
+  Progress(size_t total_ops, size_t total_bw, bool verbose = true) : total_ops_{total_ops}, total_bw_{total_bw}, verbose_{verbose} {}
 
   void Print(std::chrono::high_resolution_clock::time_point now, size_t size, uint64_t ops) {
-    PrintProgress(start_, now, size, ops, total_ops_, total_bw_);
+    if (verbose_) PrintProgress(start_, now, size, ops, total_ops_, total_bw_);
   }
 
  public:
@@ -41,5 +41,6 @@ class Progress {
  private:
   size_t total_ops_ = 0;
   size_t total_bw_ = 0;
+  bool verbose_ = true;  // ranks sharing a terminal would overwrite each other's line
   std::chrono::high_resolution_clock::time_point start_{std::chrono::high_resolution_clock::now()};
 };
@@ -1,14 +1,19 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <iostream>
 #include <random>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "common/cores.h"
 #include "common/coro.h"
 #include "common/efa.h"
 #include "common/gpuloc.h"
 #include "common/mpi.h"
 #include "common/net.h"
+#include "common/pairing.h"
 #include "common/progress.h"
 #include "common/runner.h"
 #include "common/taskset.h"
@@ -49,13 +54,17 @@ class Peer : private NoCopy {
     auto &loc = GPUloc::Get();
     auto local_rank = mpi.GetLocalRank();
     auto &affinity = loc.GetGPUAffinity()[local_rank];
-    auto cpu = affinity.cores[local_rank]->logical_index;
-    auto efa = affinity.efas[local_rank].second;
+    ASSERT(!affinity.efas.empty());
+    // GPUs sharing a PCIe switch spread over its NICs
+    auto efa = affinity.efas[local_rank % affinity.efas.size()].second;
     total_bw_ = efa->nic->link_attr->speed;
+    // only this thread is pinned
+    auto cpu = PickCPU(loc, local_rank);
 
-    std::cout << "[RANK:" << rank << "] GPU(" << local_rank << ") CPU(" << cpu << ")" << std::endl;
+    std::cout << "[RANK:" << rank << "] GPU(" << local_rank << ") CPU(" << cpu << ") EFA(" << efa->domain_attr->name << ") PEER(" << peer << ")"
+              << std::endl;
     cudaSetDevice(local_rank);
-    Taskset::Set(cpu);
+    Taskset::SetThread(cpu);
     net_.Open(efa);
     conn_ = Connect(net_, peer);
     ASSERT(!!conn_);
@@ -66,6 +75,33 @@ class Peer : private NoCopy {
   }
 
  protected:
+  /**
+   * @brief Choose the CPU of a rank's event loop
+   *
+   * A rank the launcher bound to part of its NUMA node, e.g. with the
+   * --cpu-bind=mask_cpu flags of gpuloc plan, keeps the first CPU it
+   * inherited, which is the plan's main-loop core. An unbound rank takes a
+   * whole physical core away from the interrupts of every NIC on the node,
+   * in the slot Planner would give it: ranks sharing a NUMA node take
+   * consecutive slots. Both agree as long as NVML orders GPUs by PCI address.
+   *
+   * @param loc GPU locality
+   * @param local_rank Rank on this node, also its GPU index
+   * @return OS index of the CPU
+   */
+  inline static int PickCPU(GPUloc &loc, size_t local_rank) {
+    auto &gpus = loc.GetGPUAffinity();
+    auto &affinity = gpus[local_rank];
+    auto cores = CoreAllocator(affinity.cores, loc.GetEFAs(affinity.numanode));
+    std::set<int> local;
+    for (auto &core : cores.GetCores()) local.insert(core.pus.begin(), core.pus.end());
+    auto inherited = Taskset::Get();
+    if (inherited.size() < local.size() and std::includes(local.begin(), local.end(), inherited.begin(), inherited.end())) return inherited.front();
+    size_t slot = 0;
+    for (size_t r = 0; r < local_rank; ++r) slot += gpus[r].numanode == affinity.numanode;
+    return cores.Allocate(slot).front();
+  }
+
   inline static Conn *Connect(Net &net, int peer) {
     auto &mpi = MPI::Get();
     int rank = mpi.GetWorldRank();
@@ -100,6 +136,7 @@ class Peer : private NoCopy {
   size_t num_pages_;
   size_t size_;
   size_t total_bw_;
+  bool verbose_ = MPI::Get().GetWorldRank() == 0;  // only one rank draws progress
   std::mt19937_64 rng_{0x123456789UL};
 };
 
@@ -124,14 +161,21 @@ class Writer : public Peer {
     }
   }
 
-  Coro<> Write(size_t repeat) {
+  /**
+   * @brief Write repeat rounds page by page
+   * @return Coroutine yielding the bandwidth in Gbps
+   */
+  Coro<double> Write(size_t repeat) {
+    auto start = std::chrono::steady_clock::now();
     auto total_ops = repeat * peer_regions_.size() * num_pages_;
-    auto progress = Progress(total_ops, total_bw_);
+    auto progress = Progress(total_ops, total_bw_, verbose_);
     size_t ops = 0;
     size_t sent = 0;
     for (size_t i = 0; i < repeat; ++i) {
       co_await WriteOne(progress, ops, sent);
     }
+    auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    co_return ops * page_size_ * Progress::Gb / elapse;
   }
 
   Coro<> WriteOne(Progress &progress, size_t &ops, size_t &sent) {
@@ -199,36 +243,35 @@ class Reader : public Peer {
   }
 };
 
-Coro<> StartWriter(size_t page_size, size_t num_pages, size_t repeat) {
-  auto &mpi = MPI::Get();
-  ASSERT(mpi.GetWorldRank() == 0);
-  auto peer = 1;
+Coro<double> StartWriter(int peer, size_t page_size, size_t num_pages, size_t repeat) {
   auto writer = Writer(peer, page_size, num_pages);
   co_await writer.Handshake();
-  co_await writer.Write(repeat);
+  co_return co_await writer.Write(repeat);
 }
 
-Coro<> StartReader(size_t page_size, size_t num_pages, size_t repeat) {
-  auto &mpi = MPI::Get();
-  ASSERT(mpi.GetWorldRank() == 1);
-  auto peer = 0;
+Coro<> StartReader(int peer, size_t page_size, size_t num_pages, size_t repeat) {
   auto reader = Reader(peer, page_size, num_pages);
   co_await reader.Handshake();
   co_await reader.Read(repeat);
 }
 
+/**
+ * usage: affinity [node | half]
+ *
+ * Every rank drives its own GPU and NIC; the argument picks the writer/reader
+ * pairs (see Pairing, default node). Rank 0 prints every writer's bandwidth
+ * and the aggregate per node at the end.
+ */
 int main(int argc, char *argv[]) {
-  auto &mpi = MPI::Get();
-  // assumption: 2 nodes and nproc per ndoe = 1
-  ASSERT(mpi.GetWorldSize() == 2);
-  ASSERT(mpi.GetLocalSize() == 1);
-
   constexpr size_t page_size = 256 << 10;  // 256k
   constexpr size_t num_pages = 250;
   constexpr size_t repeat = 10000;
-  if (mpi.GetWorldRank() == 0) {
-    Run(StartWriter(page_size, num_pages, repeat));
+  auto pair = Pairing::Get(argc > 1 ? argv[1] : "node");
+  double bw = 0;
+  if (pair.role == Pairing::kWriter) {
+    bw = Run(StartWriter(pair.peer, page_size, num_pages, repeat));
   } else {
-    Run(StartReader(page_size, num_pages, repeat));
+    Run(StartReader(pair.peer, page_size, num_pages, repeat));
   }
+  ReportBandwidth(bw);
 }
@@ -13,3 +13,11 @@ srun --container-image "${sqsh}" \
   --mpi=pmix \
   --ntasks-per-node=1 \
   "${binary}"
+
+# one rank per GPU, each writing through its own NIC to the same local rank on the other node
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=8 \
+  "${binary}" node
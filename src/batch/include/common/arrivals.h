@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "common/handle.h"
+#include "common/utils.h"
+
+/**
+ * @brief Per-page arrival tracking for remote writes
+ *
+ * The writer tags every group of pages with immediate data
+ * (prefix << 16) | group index. Once subscribed to the prefix through
+ * IO::Subscribe, the selector hands each such completion to Land(), which
+ * marks the group's pages in a bitmap and queues their indices in arrival
+ * order. A reader can poll the bitmap with Test() or iterate with
+ * co_await Next(), which yields page indices as they land and std::nullopt
+ * once every page of the round was yielded.
+ */
+class Arrivals : private NoCopy {
+ public:
+  /**
+   * @brief Track one round of pages
+   * @param num_pages Pages per round
+   * @param group Pages announced by one immediate
+   */
+  Arrivals(size_t num_pages, size_t group = 1) : num_pages_{num_pages}, group_{group}, bitmap_((num_pages + 63) / 64, 0) {
+    ASSERT(group >= 1 and (num_pages + group - 1) / group <= (1 << 16));
+  }
+
+  /**
+   * @brief Record the arrival of a page group (called by the selector)
+   * @param index Group index carried by the immediate data
+   * @return Handle waiting in Next() to be resumed, or nullptr
+   */
+  inline Handle *Land(uint32_t index) noexcept {
+    auto first = (size_t)index * group_;
+    for (auto page = first; page < first + group_ and page < num_pages_; ++page) {
+      bitmap_[page / 64] |= 1UL << (page % 64);
+      order_.push_back(page);
+    }
+    return std::exchange(waiter_, nullptr);
+  }
+
+  /** @brief Check whether a page of the current round landed */
+  inline bool Test(size_t page) const noexcept { return bitmap_[page / 64] & (1UL << (page % 64)); }
+  /** @brief Get the arrival bitmap, one bit per page */
+  inline const std::vector<uint64_t> &GetBitmap() const noexcept { return bitmap_; }
+  /** @brief Get pages landed in the current round */
+  inline size_t GetLanded() const noexcept { return yielded_ + order_.size(); }
+  /** @brief Check whether every page of the current round landed */
+  inline bool Done() const noexcept { return GetLanded() == num_pages_; }
+
+  /** @brief Start a new round; pages still queued are dropped */
+  inline void Reset() noexcept {
+    std::fill(bitmap_.begin(), bitmap_.end(), 0);
+    order_.clear();
+    yielded_ = 0;
+  }
+
+  /**
+   * @brief Awaiter yielding the next landed page
+   */
+  struct next_awaiter {
+    Arrivals *arrivals;
+    bool await_ready() const noexcept { return !arrivals->order_.empty() or arrivals->yielded_ == arrivals->num_pages_; }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> coroutine) noexcept {
+      coroutine.promise().SetState(Handle::kSuspend);
+      arrivals->waiter_ = &coroutine.promise();
+    }
+
+    std::optional<size_t> await_resume() noexcept {
+      auto &order = arrivals->order_;
+      if (order.empty()) return std::nullopt;
+      auto page = order.front();
+      order.pop_front();
+      ++arrivals->yielded_;
+      return page;
+    }
+  };
+
+  /** @brief Wait for the next page in arrival order */
+  inline next_awaiter Next() noexcept { return next_awaiter{this}; }
+
+ private:
+  size_t num_pages_;
+  size_t group_;
+  size_t yielded_ = 0;
+  std::vector<uint64_t> bitmap_;
+  std::deque<size_t> order_;
+  Handle *waiter_ = nullptr;
+};
@@ -1,6 +1,10 @@
 #pragma once
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <utility>
@@ -8,8 +12,52 @@
 #include "common/buffer.h"
 #include "common/coro.h"
 #include "common/event.h"
+#include "common/future.h"
 #include "common/utils.h"
 
+/**
+ * @brief Remote memory region advertised by a peer
+ */
+struct Region {
+  uint64_t addr;
+  uint64_t size;
+  uint64_t key;
+};
+
+/**
+ * @brief Segment size and pipeline depth used by Conn::Transfer
+ *
+ * The pipeline keeps at least two bandwidth-delay products in flight (and
+ * never less than kMinInflight, which is what saturates EFA in practice), split
+ * into about kDepth segments bounded by the provider's max_msg_size.
+ */
+struct Pipeline {
+  size_t segment;  ///< Bytes per RMA write
+  size_t depth;    ///< RMA writes kept in flight
+
+  inline constexpr static size_t kMinSegment = 64 << 10;
+  inline constexpr static size_t kMaxSegment = 1 << 20;
+  inline constexpr static size_t kMinInflight = 2 << 20;
+  inline constexpr static size_t kDepth = 8;
+  inline constexpr static size_t kMaxDepth = 64;
+
+  /**
+   * @brief Derive segment size and depth from the link
+   * @param speed Link speed in bits per second (0 if unknown)
+   * @param max_msg_size Largest message the endpoint accepts (0 if unknown)
+   * @param rtt Observed round-trip time
+   * @return Pipeline parameters
+   */
+  inline static Pipeline Tune(size_t speed, size_t max_msg_size, std::chrono::nanoseconds rtt) {
+    auto bdp = speed / 8 * rtt.count() / 1000000000;
+    auto inflight = std::max<size_t>(2 * bdp, kMinInflight);
+    auto limit = max_msg_size ? std::min(max_msg_size, kMaxSegment) : kMaxSegment;
+    auto segment = std::bit_floor(std::clamp(inflight / kDepth, std::min(kMinSegment, limit), limit));
+    auto depth = std::clamp<size_t>((inflight + segment - 1) / segment, 2, kMaxDepth);
+    return {segment, depth};
+  }
+};
+
 /**
  * @brief RDMA connection with coroutine-based async I/O
  */
@@ -20,14 +68,19 @@ class Conn : private NoCopy {
    * @param ep Fabric endpoint handle
    * @param domain RDMA domain for buffer registration
    * @param remote Remote endpoint address
+   * @param info Fabric info of the endpoint, used to size Transfer segments
    */
-  Conn(struct fid_ep *ep, struct fid_domain *domain, fi_addr_t remote)
+  Conn(struct fid_ep *ep, struct fid_domain *domain, fi_addr_t remote, struct fi_info *info = nullptr)
       : ep_{ep},
         remote_{remote},
         recv_buffer_{HostBuffer(domain, kBufferSize)},
         send_buffer_{HostBuffer(domain, kBufferSize)},
         read_buffer_{CUDABuffer(domain, kMemoryRegionSize)},
-        write_buffer_{CUDABuffer(domain, kMemoryRegionSize)} {}
+        write_buffer_{CUDABuffer(domain, kMemoryRegionSize)} {
+    if (info and info->nic and info->nic->link_attr) speed_ = info->nic->link_attr->speed;
+    if (info and info->ep_attr) max_msg_size_ = info->ep_attr->max_msg_size;
+    pipeline_ = Pipeline::Tune(speed_, max_msg_size_, rtt_);
+  }
 
   /**
    * @brief Awaiter for asynchronous receive operations
@@ -113,11 +166,13 @@ class Conn : private NoCopy {
   struct write_awaiter {
     Conn *conn{0};
     Context context{0};
+    const char *data{0};
     size_t size{0};
     uint64_t addr{0};
     uint64_t key{0};
     uint64_t imm_data{0};
-    write_awaiter(Conn *c, size_t sz, uint64_t a, uint64_t k, uint64_t i) : conn{c}, size{sz}, addr{a}, key{k}, imm_data{i} {}
+    write_awaiter(Conn *c, const char *d, size_t sz, uint64_t a, uint64_t k, uint64_t i)
+        : conn{c}, data{d}, size{sz}, addr{a}, key{k}, imm_data{i} {}
     constexpr bool await_ready() const noexcept { return false; }
 
     template <typename Promise>
@@ -128,7 +183,7 @@ class Conn : private NoCopy {
       struct iovec iov;
       struct fi_rma_iov rma_iov;
       struct fi_msg_rma msg;
-      iov.iov_base = buffer.GetData();
+      iov.iov_base = (void *)data;
       iov.iov_len = size;
       rma_iov.addr = addr;
       rma_iov.len = size;
@@ -170,7 +225,9 @@ class Conn : private NoCopy {
     bool await_suspend(std::coroutine_handle<Promise> coroutine) {
       coroutine.promise().SetState(Handle::kSuspend);
       context.handle = &coroutine.promise();
-      IO::Get().Register(imm_data, &context);
+      auto &io = IO::Get();
+      if (io.Claim(imm_data, &context)) return false;
+      io.Register(imm_data, &context);
       return true;
     }
 
@@ -207,6 +264,47 @@ class Conn : private NoCopy {
 
   Coro<char *> Read(uint64_t imm_data) { return Read(oneway, imm_data); }
 
+  /**
+   * @brief Write an arbitrary-size payload to a remote region
+   *
+   * The payload is split into Pipeline::segment sized RMA writes with up to
+   * Pipeline::depth in flight. Only the last segment carries imm_data and it
+   * is posted after every other segment completed, since RDM writes may land
+   * out of order; the peer's Read(imm_data) therefore resumes once the whole
+   * payload landed. The observed RTT retunes the pipeline after each transfer.
+   *
+   * @param src Payload inside the write buffer
+   * @param len Payload size in bytes
+   * @param region Destination region (len must fit in region.size)
+   * @param imm_data Completion immediate data for the last segment
+   * @return Coroutine yielding bytes written
+   * @throws std::invalid_argument on a bad source or destination
+   */
+  Coro<size_t> Transfer(const char *src, size_t len, const Region &region, uint64_t imm_data) {
+    return Transfer(oneway, src, len, region, imm_data);
+  }
+
+  /**
+   * @brief Write pages so that the peer can consume each one as it lands
+   *
+   * Every group of pages becomes one RMA write tagged with
+   * (prefix << 16) | group index, with as many writes in flight as the
+   * current Pipeline keeps bytes in flight. The peer tracks them with an
+   * Arrivals subscribed to prefix instead of waiting for the whole payload.
+   *
+   * @param src First page inside the write buffer
+   * @param page_size Page size in bytes
+   * @param num_pages Number of pages
+   * @param region Destination region
+   * @param prefix Upper 16 bits of every immediate data (non-zero)
+   * @param group Pages per write and per immediate
+   * @return Coroutine yielding bytes written
+   * @throws std::invalid_argument on a bad source, destination or prefix
+   */
+  Coro<size_t> TransferPages(const char *src, size_t page_size, size_t num_pages, const Region &region, uint32_t prefix, size_t group = 1) {
+    return TransferPages(oneway, src, page_size, num_pages, region, prefix, group);
+  }
+
   /** @brief Get send buffer reference */
   inline HostBuffer &GetSendBuffer() noexcept { return send_buffer_; }
   /** @brief Get receive buffer reference */
@@ -215,6 +313,10 @@ class Conn : private NoCopy {
   inline CUDABuffer &GetWriteBuffer() noexcept { return write_buffer_; }
   /** @brief Get CUDA read buffer reference */
   inline CUDABuffer &GetReadBuffer() noexcept { return read_buffer_; }
+  /** @brief Get current Transfer segmentation */
+  inline const Pipeline &GetPipeline() const noexcept { return pipeline_; }
+  /** @brief Get smoothed round-trip time observed by Transfer */
+  inline std::chrono::nanoseconds GetRTT() const noexcept { return rtt_; }
 
  private:
   /**
@@ -244,9 +346,76 @@ class Conn : private NoCopy {
   }
 
   Coro<size_t> Write(Oneway, const char *data, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
-    if (!data) std::invalid_argument("Write data is NULL");
+    if (!data) throw std::invalid_argument("Write data is NULL");
     if (sz <= 0) throw std::invalid_argument("Write buffer size should be greater than 0");
-    co_return co_await write_awaiter(this, sz, addr, key, imm_data);
+    co_return co_await write_awaiter(this, data, sz, addr, key, imm_data);
+  }
+
+  Coro<size_t> Transfer(Oneway, const char *src, size_t len, Region region, uint64_t imm_data) {
+    using clock = std::chrono::steady_clock;
+    auto base = (const char *)write_buffer_.GetData();
+    if (!src or src < base or src + len > base + write_buffer_.GetSize()) throw std::invalid_argument("Transfer source outside write buffer");
+    if (len <= 0) throw std::invalid_argument("Transfer size should be greater than 0");
+    if (len > region.size) throw std::invalid_argument("Transfer size exceeds remote region");
+    if (imm_data == 0) throw std::invalid_argument("imm_data should be greater than 0");
+
+    auto [segment, depth] = pipeline_;
+    std::deque<std::pair<Future<Coro<size_t>>, clock::time_point>> futs;
+    auto sample = clock::duration::max();
+    for (size_t off = 0; off < len; off += segment) {
+      while (futs.size() >= depth) {
+        co_await futs.front().first;
+        sample = std::min(sample, clock::now() - futs.front().second);
+        futs.pop_front();
+      }
+      auto sz = std::min(segment, len - off);
+      auto is_final = off + sz == len;
+      while (is_final and !futs.empty()) {
+        co_await futs.front().first;
+        sample = std::min(sample, clock::now() - futs.front().second);
+        futs.pop_front();
+      }
+      auto start = clock::now();
+      futs.emplace_back(Future(Write(src + off, sz, region.addr + off, region.key, is_final ? imm_data : 0)), start);
+    }
+    for (auto &[fut, start] : futs) {
+      co_await fut;
+      sample = std::min(sample, clock::now() - start);
+    }
+
+    // the fastest completion approximates one RTT plus the segment's serialization
+    auto wire = speed_ ? std::chrono::nanoseconds(segment * 8 * 1000000000 / speed_) : std::chrono::nanoseconds(0);
+    auto rtt = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(sample) - wire, std::chrono::nanoseconds(0));
+    rtt_ = (rtt_ * 7 + rtt) / 8;
+    pipeline_ = Pipeline::Tune(speed_, max_msg_size_, rtt_);
+    co_return len;
+  }
+
+  Coro<size_t> TransferPages(Oneway, const char *src, size_t page_size, size_t num_pages, Region region, uint32_t prefix, size_t group) {
+    auto base = (const char *)write_buffer_.GetData();
+    auto len = page_size * num_pages;
+    if (!src or src < base or src + len > base + write_buffer_.GetSize()) throw std::invalid_argument("TransferPages source outside write buffer");
+    if (len <= 0 or group <= 0) throw std::invalid_argument("TransferPages size should be greater than 0");
+    if (len > region.size) throw std::invalid_argument("TransferPages size exceeds remote region");
+    if (prefix == 0 or prefix > 0xffff) throw std::invalid_argument("TransferPages prefix should be in [1, 0xffff]");
+    auto bytes = page_size * group;
+    if (max_msg_size_ and bytes > max_msg_size_) throw std::invalid_argument("TransferPages group exceeds max_msg_size");
+    auto groups = (num_pages + group - 1) / group;
+    if (groups > (1 << 16)) throw std::invalid_argument("TransferPages needs a larger group");
+
+    auto depth = std::max<size_t>(2, pipeline_.segment * pipeline_.depth / bytes);
+    std::deque<Future<Coro<size_t>>> futs;
+    for (size_t g = 0; g < groups; ++g) {
+      while (futs.size() >= depth) {
+        co_await futs.front();
+        futs.pop_front();
+      }
+      auto off = g * bytes;
+      auto sz = std::min(bytes, len - off);
+      futs.emplace_back(Future(Write(src + off, sz, region.addr + off, region.key, (prefix << 16) | g)));
+    }
+    for (auto &fut : futs) co_await fut;
+    co_return len;
   }
 
   Coro<char *> Read(Oneway, uint64_t imm_data) {
@@ -257,6 +426,10 @@ class Conn : private NoCopy {
  private:
   struct fid_ep *ep_ = nullptr;
   fi_addr_t remote_;
+  size_t speed_ = 0;
+  size_t max_msg_size_ = 0;
+  std::chrono::nanoseconds rtt_{20000};  // initial guess, refined by Transfer
+  Pipeline pipeline_;
   HostBuffer recv_buffer_;
   HostBuffer send_buffer_;
   CUDABuffer read_buffer_;
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "common/conn.h"
+#include "common/coro.h"
+#include "common/future.h"
+#include "common/hash.h"
+
+/**
+ * @brief Dirty-page manifest announcing which pages of a push changed
+ *
+ * Encoded as a header followed by either (first, count) runs or a bitmap,
+ * whichever is smaller, so a sparse push costs a few bytes and a dense one
+ * at most one bit per page.
+ */
+struct Manifest {
+  enum Kind : uint32_t { kRuns, kBitmap };
+
+  struct Header {
+    uint32_t version;
+    uint32_t kind;
+    uint32_t words;  ///< runs or 64-bit bitmap words following the header
+    uint32_t dirty;  ///< number of dirty pages
+  };
+
+  struct Run {
+    uint32_t first;
+    uint32_t count;
+  };
+
+  /** @brief Largest encoding for num_pages pages */
+  inline static size_t MaxSize(size_t num_pages) { return sizeof(Header) + std::min((num_pages + 1) / 2 * sizeof(Run), (num_pages + 63) / 64 * 8); }
+
+  /**
+   * @brief Encode runs of dirty pages
+   * @param version Push version
+   * @param num_pages Pages in the region
+   * @param runs Dirty runs in ascending order
+   * @return Encoded manifest
+   */
+  inline static std::vector<char> Encode(uint32_t version, size_t num_pages, const std::vector<Run> &runs) {
+    uint32_t dirty = 0;
+    for (auto &r : runs) dirty += r.count;
+    auto words = (num_pages + 63) / 64;
+    std::vector<char> out;
+    if (runs.size() * sizeof(Run) <= words * sizeof(uint64_t)) {
+      Header h{version, kRuns, (uint32_t)runs.size(), dirty};
+      out.resize(sizeof(h) + runs.size() * sizeof(Run));
+      std::memcpy(out.data(), &h, sizeof(h));
+      if (!runs.empty()) std::memcpy(out.data() + sizeof(h), runs.data(), runs.size() * sizeof(Run));
+      return out;
+    }
+    std::vector<uint64_t> bitmap(words, 0);
+    for (auto &r : runs) {
+      for (auto p = r.first; p < r.first + r.count; ++p) bitmap[p / 64] |= 1UL << (p % 64);
+    }
+    Header h{version, kBitmap, (uint32_t)words, dirty};
+    out.resize(sizeof(h) + words * sizeof(uint64_t));
+    std::memcpy(out.data(), &h, sizeof(h));
+    std::memcpy(out.data() + sizeof(h), bitmap.data(), words * sizeof(uint64_t));
+    return out;
+  }
+
+  /**
+   * @brief Decode a manifest into dirty page indices
+   * @param data Encoded manifest
+   * @param header Receives the header
+   * @return Dirty pages in ascending order
+   */
+  inline static std::vector<size_t> Decode(const char *data, Header &header) {
+    std::memcpy(&header, data, sizeof(header));
+    std::vector<size_t> pages;
+    pages.reserve(header.dirty);
+    auto payload = data + sizeof(header);
+    for (uint32_t i = 0; i < header.words; ++i) {
+      if (header.kind == kRuns) {
+        Run r;
+        std::memcpy(&r, payload + i * sizeof(Run), sizeof(r));
+        for (auto p = r.first; p < r.first + r.count; ++p) pages.push_back(p);
+      } else {
+        uint64_t w;
+        std::memcpy(&w, payload + i * sizeof(w), sizeof(w));
+        for (; w; w &= w - 1) pages.push_back(i * 64 + __builtin_ctzll(w));
+      }
+    }
+    return pages;
+  }
+};
+
+/**
+ * @brief Writer side of dirty-page delta synchronization
+ *
+ * The application updates a host copy of the region. Push() hashes every page
+ * with PageHash, compares against the hashes of the previous push and sends
+ * only the changed pages: contiguous dirty pages are staged into the GPU write
+ * buffer and written as one run, split into Pipeline segments. Once every run
+ * completed, the manifest is written right behind the region with immediate
+ * data (kPrefix << 16) | version, which commits the push on the reader.
+ */
+class DeltaSync : private NoCopy {
+ public:
+  /** @brief Upper 16 bits of the commit immediate */
+  inline constexpr static uint32_t kPrefix = 0x3;
+
+  /** @brief Cost breakdown of one push */
+  struct Stats {
+    size_t dirty = 0;  ///< pages sent
+    size_t runs = 0;   ///< contiguous runs sent
+    size_t wire = 0;   ///< payload and manifest bytes written
+    std::chrono::nanoseconds hash{0};
+    std::chrono::nanoseconds push{0};
+  };
+
+  /**
+   * @brief Track a page_size * num_pages region
+   * @param conn Connection to the replica
+   * @param page_size Page size in bytes
+   * @param num_pages Number of pages
+   */
+  DeltaSync(Conn *conn, size_t page_size, size_t num_pages)
+      : conn_{conn}, page_size_{page_size}, num_pages_{num_pages}, state_(page_size * num_pages), hashes_(num_pages) {
+    ASSERT(num_pages < (1UL << 32));
+    ASSERT(page_size * num_pages + Manifest::MaxSize(num_pages) <= conn->GetWriteBuffer().GetSize());
+  }
+
+  /** @brief Get the host copy the application updates */
+  inline std::vector<char> &GetState() noexcept { return state_; }
+
+  /**
+   * @brief Send the pages that changed since the previous push
+   * @param region Replica region; the manifest lands at region.addr + page_size * num_pages
+   * @return Coroutine yielding the cost of the push
+   */
+  Coro<Stats> Push(const Region &region) {
+    using clock = std::chrono::steady_clock;
+    Stats stats;
+    auto start = clock::now();
+    std::vector<Manifest::Run> runs;
+    for (size_t p = 0; p < num_pages_; ++p) {
+      auto h = PageHash::Run(state_.data() + p * page_size_, page_size_);
+      if (synced_ and h == hashes_[p]) continue;
+      hashes_[p] = h;
+      if (!runs.empty() and runs.back().first + runs.back().count == p) {
+        ++runs.back().count;
+      } else {
+        runs.push_back({(uint32_t)p, 1});
+      }
+    }
+    stats.hash = clock::now() - start;
+
+    auto cuda_buffer = (char *)conn_->GetWriteBuffer().GetData();
+    auto [segment, depth] = conn_->GetPipeline();
+    std::deque<Future<Coro<size_t>>> futs;
+    for (auto &run : runs) {
+      auto off = run.first * page_size_;
+      auto len = run.count * page_size_;
+      CUDA_CHECK(cudaMemcpy(cuda_buffer + off, state_.data() + off, len, cudaMemcpyHostToDevice));
+      for (size_t o = off; o < off + len; o += segment) {
+        while (futs.size() >= depth) {
+          co_await futs.front();
+          futs.pop_front();
+        }
+        auto sz = std::min(segment, off + len - o);
+        futs.emplace_back(Future(conn_->Write(cuda_buffer + o, sz, region.addr + o, region.key)));
+      }
+      stats.dirty += run.count;
+      stats.wire += len;
+    }
+    // RDM writes may land out of order, so commit only after every run completed
+    for (auto &f : futs) co_await f;
+
+    auto manifest = Manifest::Encode(version_, num_pages_, runs);
+    auto tail = page_size_ * num_pages_;
+    CUDA_CHECK(cudaMemcpy(cuda_buffer + tail, manifest.data(), manifest.size(), cudaMemcpyHostToDevice));
+    co_await conn_->Write(cuda_buffer + tail, manifest.size(), region.addr + tail, region.key, Commit(version_));
+    ++version_;
+    synced_ = true;
+    stats.runs = runs.size();
+    stats.wire += manifest.size();
+    stats.push = clock::now() - start;
+    co_return stats;
+  }
+
+  /** @brief Immediate data committing a version */
+  inline static uint32_t Commit(uint32_t version) noexcept { return (kPrefix << 16) | (version & 0xffff); }
+
+ private:
+  Conn *conn_;
+  size_t page_size_;
+  size_t num_pages_;
+  uint32_t version_ = 0;
+  bool synced_ = false;  // the first push sends every page
+  std::vector<char> state_;
+  std::vector<uint64_t> hashes_;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/parallel.h"
+
+/**
+ * @brief Fast 64-bit page hash for change detection
+ *
+ * An xxh3-style accumulate loop: four 64-bit lanes consume one 32-byte stripe
+ * per step, each lane adds the neighbour lane's word and the product of the
+ * low and high halves of its own word xor a per-lane secret. The AVX2 kernel
+ * processes a stripe per instruction and gives bit-identical results to the
+ * scalar loop. It is not a cryptographic hash; it only has to tell whether a
+ * page changed since the last time it was hashed on the same host.
+ */
+struct PageHash {
+  /** @brief Bytes consumed per step */
+  inline constexpr static size_t kStripe = 32;
+
+  /** @brief Check whether the AVX2 kernel is used */
+  inline static bool HasAVX2() {
+#if defined(__x86_64__)
+    static const bool avx2 = [] {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+  }
+
+  /** @brief Name of the kernel in use */
+  inline static std::string_view Name() { return HasAVX2() ? "avx2" : "scalar"; }
+
+  /**
+   * @brief Hash a buffer
+   * @param data Buffer
+   * @param len Length in bytes; a tail shorter than a stripe is hashed by the scalar loop
+   * @return 64-bit hash
+   */
+  inline static uint64_t Run(const void *data, size_t len) {
+    uint64_t acc[4] = {kPrime1, kPrime2, kPrime3, kPrime4};
+    auto p = (const uint8_t *)data;
+    size_t stripes = len / kStripe;
+#if defined(__x86_64__)
+    if (HasAVX2()) {
+      AVX2(acc, p, stripes);
+    } else {
+      Scalar(acc, p, stripes);
+    }
+#else
+    Scalar(acc, p, stripes);
+#endif
+    uint64_t h = len * kPrime1;
+    for (int j = 0; j < 4; ++j) h = Mix(h ^ acc[j]) * kPrime2;
+    for (size_t i = stripes * kStripe; i < len; ++i) h = Mix(h ^ p[i]) * kPrime3;
+    return Mix(h);
+  }
+
+  /**
+   * @brief Hash every page of a buffer, spreading pages across threads
+   * @param data Buffer of page_size * num_pages bytes
+   * @param page_size Page size in bytes
+   * @param num_pages Number of pages
+   * @return One hash per page
+   */
+  inline static std::vector<uint64_t> Pages(const void *data, size_t page_size, size_t num_pages) {
+    std::vector<uint64_t> sums(num_pages);
+    auto p = (const uint8_t *)data;
+    ParallelFor(num_pages * page_size, page_size, [&](size_t begin, size_t end) {
+      for (auto off = begin; off < end; off += page_size) sums[off / page_size] = Run(p + off, page_size);
+    });
+    return sums;
+  }
+
+ private:
+  inline constexpr static uint64_t kPrime1 = 0x9e3779b185ebca87ULL;
+  inline constexpr static uint64_t kPrime2 = 0xc2b2ae3d27d4eb4fULL;
+  inline constexpr static uint64_t kPrime3 = 0x165667b19e3779f9ULL;
+  inline constexpr static uint64_t kPrime4 = 0x85ebca77c2b2ae63ULL;
+  inline constexpr static uint64_t kSecret[4] = {0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL};
+
+  /** @brief murmur3 finalizer */
+  inline static uint64_t Mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  inline static void Scalar(uint64_t acc[4], const uint8_t *p, size_t stripes) {
+    for (size_t s = 0; s < stripes; ++s, p += kStripe) {
+      uint64_t d[4];
+      std::memcpy(d, p, sizeof(d));
+      for (int j = 0; j < 4; ++j) {
+        auto k = d[j] ^ kSecret[j];
+        acc[j ^ 1] += d[j];
+        acc[j] += (k & 0xffffffff) * (k >> 32);
+      }
+    }
+  }
+
+#if defined(__x86_64__)
+  __attribute__((target("avx2"))) static void AVX2(uint64_t acc[4], const uint8_t *p, size_t stripes) {
+    auto a = _mm256_loadu_si256((const __m256i *)acc);
+    const auto secret = _mm256_loadu_si256((const __m256i *)kSecret);
+    for (size_t s = 0; s < stripes; ++s, p += kStripe) {
+      auto d = _mm256_loadu_si256((const __m256i *)p);
+      auto k = _mm256_xor_si256(d, secret);
+      auto product = _mm256_mul_epu32(k, _mm256_srli_epi64(k, 32));
+      // swap 64-bit neighbours so lane j receives the word of lane j ^ 1
+      auto swapped = _mm256_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+      a = _mm256_add_epi64(a, _mm256_add_epi64(product, swapped));
+    }
+    _mm256_storeu_si256((__m256i *)acc, a);
+  }
+#endif
+};
@@ -131,6 +131,24 @@ class IO : private NoCopy {
     selector_.Register(id, std::forward<T>(event));
   }
 
+  /**
+   * @brief Take a remote write with this immediate data that arrived early
+   * @param id Immediate data
+   * @param context Receives the completion entry
+   * @return true if one was buffered
+   */
+  inline bool Claim(uint64_t id, Context *context) { return selector_.Claim(id, context); }
+
+  /**
+   * @brief Deliver remote writes tagged with prefix to a page tracker
+   * @param prefix Upper 16 bits of the immediate data
+   * @param arrivals Tracker receiving every matching write
+   */
+  inline void Subscribe(uint32_t prefix, Arrivals *arrivals) { selector_.Subscribe(prefix, arrivals); }
+
+  /** @brief Stop delivering writes tagged with prefix */
+  inline void Unsubscribe(uint32_t prefix) { selector_.Unsubscribe(prefix); }
+
   /**
    * @brief Unregister event source from selector
    * @param event Event source to unregister
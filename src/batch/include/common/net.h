@@ -95,6 +95,7 @@ class Net {
   struct fid_ep *ep_ = nullptr;
   struct fid_cq *cq_ = nullptr;
   struct fid_av *av_ = nullptr;
+  struct fi_info *info_ = nullptr;
   char addr_[kMaxAddrSize] = {0};
   std::unordered_map<std::string, std::unique_ptr<Conn>> conns_;
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Split [0, n) into contiguous chunks and run fn(begin, end) on each in its own thread
+ *
+ * Chunk boundaries are multiples of align, so SIMD kernels only see a tail in
+ * the last chunk. Chunks are at least 1M items (bytes for the buffer
+ * kernels), so small ranges run on the calling thread.
+ *
+ * @param n Number of items
+ * @param align Chunk granularity in items
+ * @param fn Callable taking (begin, end)
+ * @param threads Number of threads, 0 for one per hardware thread
+ */
+template <typename F>
+inline void ParallelFor(size_t n, size_t align, F &&fn, size_t threads = 0) {
+  constexpr size_t kMinChunk = 1 << 20;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = std::min(threads, std::max<size_t>(1, n / kMinChunk));
+  if (threads == 1) {
+    fn(size_t{0}, n);
+    return;
+  }
+  auto chunk = (n / threads + align - 1) / align * align;
+  std::vector<std::thread> workers;
+  for (size_t begin = 0; begin < n; begin += chunk) {
+    workers.emplace_back([&fn, begin, end = std::min(n, begin + chunk)] { fn(begin, end); });
+  }
+  for (auto &w : workers) w.join();
+}
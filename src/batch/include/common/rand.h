@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "common/parallel.h"
+#include "common/utils.h"
+
+/**
+ * @brief Philox4x32-10 counter-based generator
+ *
+ * Block i of the stream is Philox(counter = i, key = seed) and yields 16
+ * bytes, so any byte range can be generated without the bytes in front of it.
+ * Fill() splits a buffer across threads and the AVX2 kernel computes four
+ * blocks per step; both give the same bytes as the scalar kernel. A 62.5 MB
+ * batch region takes milliseconds instead of the seconds a sequential
+ * mt19937_64 needs.
+ */
+struct Philox {
+  /** @brief Bytes per block */
+  inline constexpr static size_t kBlock = 16;
+
+  /** @brief Check whether the AVX2 kernel is used */
+  inline static bool HasAVX2() {
+#if defined(__x86_64__)
+    static const bool avx2 = [] {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+  }
+
+  /** @brief Name of the kernel in use */
+  inline static std::string_view Name() { return HasAVX2() ? "avx2" : "scalar"; }
+
+  /**
+   * @brief Fill a buffer with the stream of a seed
+   * @param seed Stream key
+   * @param data Buffer
+   * @param size Buffer size, a multiple of kBlock
+   * @param offset Stream position of data[0], a multiple of kBlock
+   */
+  inline static void Fill(uint64_t seed, void *data, size_t size, size_t offset = 0) {
+    ASSERT(size % kBlock == 0 and offset % kBlock == 0);
+    auto out = (uint8_t *)data;
+    ParallelFor(size, 4 * kBlock, [&](size_t begin, size_t end) { Generate(seed, (offset + begin) / kBlock, (end - begin) / kBlock, out + begin); });
+  }
+
+  /**
+   * @brief Generate consecutive blocks on the calling thread
+   * @param seed Stream key
+   * @param counter First block index
+   * @param blocks Number of blocks
+   * @param out Destination of blocks * kBlock bytes
+   */
+  inline static void Generate(uint64_t seed, uint64_t counter, size_t blocks, uint8_t *out) {
+    size_t done = 0;
+#if defined(__x86_64__)
+    if (HasAVX2()) done = AVX2(seed, counter, blocks / 4 * 4, out);
+#endif
+    for (; done < blocks; ++done) Scalar(seed, counter + done, out + done * kBlock);
+  }
+
+ private:
+  inline constexpr static uint32_t kM0 = 0xD2511F53;
+  inline constexpr static uint32_t kM1 = 0xCD9E8D57;
+  inline constexpr static uint32_t kW0 = 0x9E3779B9;
+  inline constexpr static uint32_t kW1 = 0xBB67AE85;
+  inline constexpr static int kRounds = 10;
+
+  inline static void Scalar(uint64_t seed, uint64_t counter, uint8_t *out) {
+    uint32_t c[4] = {(uint32_t)counter, (uint32_t)(counter >> 32), 0, 0};
+    uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+    for (int r = 0; r < kRounds; ++r) {
+      uint64_t p0 = (uint64_t)kM0 * c[0];
+      uint64_t p1 = (uint64_t)kM1 * c[2];
+      uint32_t n[4] = {(uint32_t)(p1 >> 32) ^ c[1] ^ k0, (uint32_t)p1, (uint32_t)(p0 >> 32) ^ c[3] ^ k1, (uint32_t)p0};
+      std::memcpy(c, n, sizeof(c));
+      k0 += kW0;
+      k1 += kW1;
+    }
+    std::memcpy(out, c, sizeof(c));
+  }
+
+#if defined(__x86_64__)
+  /**
+   * Four blocks per step: every 64-bit lane holds one word of one block in its
+   * low half, which is what _mm256_mul_epu32 multiplies.
+   */
+  __attribute__((target("avx2"))) static size_t AVX2(uint64_t seed, uint64_t counter, size_t blocks, uint8_t *out) {
+    const auto lo = _mm256_set1_epi64x(0xffffffff);
+    const auto m0 = _mm256_set1_epi64x(kM0);
+    const auto m1 = _mm256_set1_epi64x(kM1);
+    const auto step = _mm256_set1_epi64x(4);
+    auto ctr = _mm256_add_epi64(_mm256_set1_epi64x(counter), _mm256_setr_epi64x(0, 1, 2, 3));
+    for (size_t b = 0; b < blocks; b += 4, out += 4 * kBlock) {
+      auto c0 = _mm256_and_si256(ctr, lo);
+      auto c1 = _mm256_srli_epi64(ctr, 32);
+      auto c2 = _mm256_setzero_si256();
+      auto c3 = _mm256_setzero_si256();
+      uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+      for (int r = 0; r < kRounds; ++r) {
+        auto p0 = _mm256_mul_epu32(c0, m0);
+        auto p1 = _mm256_mul_epu32(c2, m1);
+        auto n0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+        auto n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+        c1 = _mm256_and_si256(p1, lo);
+        c3 = _mm256_and_si256(p0, lo);
+        c0 = n0;
+        c2 = n2;
+        k0 += kW0;
+        k1 += kW1;
+      }
+      // per block: a = c0 | c1 << 32, b = c2 | c3 << 32, stored as a, b
+      auto a = _mm256_or_si256(c0, _mm256_slli_epi64(c1, 32));
+      auto z = _mm256_or_si256(c2, _mm256_slli_epi64(c3, 32));
+      auto even = _mm256_unpacklo_epi64(a, z);  // blocks 0, 2
+      auto odd = _mm256_unpackhi_epi64(a, z);   // blocks 1, 3
+      _mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(even, odd, 0x20));
+      _mm256_storeu_si256((__m256i *)(out + 2 * kBlock), _mm256_permute2x128_si256(even, odd, 0x31));
+      ctr = _mm256_add_epi64(ctr, step);
+    }
+    return blocks;
+  }
+#endif
+};
@@ -6,11 +6,13 @@
 #include <rdma/fi_endpoint.h>
 #include <spdlog/spdlog.h>
 
+#include <deque>
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "common/arrivals.h"
 #include "common/event.h"
 #include "common/utils.h"
 
@@ -59,6 +61,30 @@ class Selector {
 
   inline void UnRegister(uint64_t id) { imm_data_contexts_.erase(id); }
 
+  /**
+   * @brief Claim a remote write that arrived before anyone waited for it
+   * @param id Immediate data to look for
+   * @param context Receives the buffered completion entry
+   * @return true if an early completion was handed over
+   */
+  inline bool Claim(uint64_t id, Context *context) {
+    auto it = early_.find(id);
+    if (it == early_.end()) return false;
+    context->entry = it->second.front();
+    it->second.pop_front();
+    if (it->second.empty()) early_.erase(it);
+    return true;
+  }
+
+  /**
+   * @brief Route remote writes whose immediate data starts with prefix to arrivals
+   * @param prefix Upper 16 bits of the immediate data
+   * @param arrivals Page tracker receiving the lower 16 bits
+   */
+  inline void Subscribe(uint32_t prefix, Arrivals *arrivals) { streams_.emplace(prefix, arrivals); }
+
+  inline void Unsubscribe(uint32_t prefix) { streams_.erase(prefix); }
+
   /**
    * @brief Check if selector has no registered queues
    * @return true if no completion queues registered
@@ -73,7 +99,16 @@ class Selector {
       if (flags & FI_REMOTE_WRITE) {
         uint32_t imm_data = entry.data;
         if (!imm_data) continue;
-        if (!imm_data_contexts_.contains(imm_data)) continue;
+        if (!imm_data_contexts_.contains(imm_data)) {
+          auto it = streams_.find(imm_data >> 16);
+          if (it == streams_.end()) {
+            // nobody waits yet; keep it for the next Read of this imm_data
+            early_[imm_data].emplace_back(entry);
+            continue;
+          }
+          if (auto handle = it->second->Land(imm_data & 0xffff)) ret.emplace_back(Event{flags, handle});
+          continue;
+        }
         auto context = imm_data_contexts_[imm_data];
         context->entry = entry;
         Handle *handle = context->handle;
@@ -108,4 +143,6 @@ class Selector {
  private:
   std::unordered_set<struct fid_cq *> cqs_;
   std::unordered_map<uint64_t, Context *> imm_data_contexts_;
+  std::unordered_map<uint32_t, Arrivals *> streams_;
+  std::unordered_map<uint64_t, std::deque<struct fi_cq_data_entry>> early_;
 };
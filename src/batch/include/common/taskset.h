@@ -1,6 +1,7 @@
 #pragma once
 
 #include <errno.h>
+#include <pthread.h>
 #include <sched.h>
 #include <spdlog/spdlog.h>
 #include <unistd.h>
@@ -45,4 +46,39 @@ struct Taskset {
     pid_t pid = getpid();
     TASKSET_CHECK(sched_setaffinity(pid, sizeof(mask), &mask));
   }
+
+  /**
+   * @brief Get the CPUs the current process may run on, e.g. as bound by the launcher
+   * @return OS indices of the CPUs in ascending order
+   * @throws std::runtime_error if sched_getaffinity fails
+   */
+  inline static std::vector<int> Get() {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    TASKSET_CHECK(sched_getaffinity(getpid(), sizeof(mask), &mask));
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) cpus.emplace_back(cpu);
+    }
+    return cpus;
+  }
+
+  /**
+   * @brief Bind a single thread to a specific CPU, leaving the rest of the process unpinned
+   * @param cpu OS index of the CPU
+   * @param thread Thread to bind, the calling thread by default
+   * @throws std::runtime_error if pthread_setaffinity_np fails
+   */
+  inline static void SetThread(int cpu, pthread_t thread = pthread_self()) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    // pthread functions return the error number instead of setting errno
+    auto rc = pthread_setaffinity_np(thread, sizeof(mask), &mask);
+    if (rc) {
+      auto msg = fmt::format("pthread_setaffinity_np fail. error: {}", strerror(rc));
+      SPDLOG_ERROR(msg);
+      throw std::runtime_error(msg);
+    }
+  }
 };
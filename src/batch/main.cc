@@ -1,36 +1,59 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
-#include <deque>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <numeric>
 #include <random>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "common/arrivals.h"
+#include "common/cores.h"
 #include "common/coro.h"
+#include "common/crc32c.h"
+#include "common/delta.h"
 #include "common/efa.h"
 #include "common/gpuloc.h"
 #include "common/mpi.h"
 #include "common/net.h"
+#include "common/pairing.h"
 #include "common/progress.h"
+#include "common/rand.h"
 #include "common/runner.h"
 #include "common/taskset.h"
 #include "common/timer.h"
 
-#define MSGSIZE(msg) (sizeof(Message) + (sizeof(CUDARegion) * msg->num))
+#define MSGSIZE(msg) (sizeof(Message) + (sizeof(Region) * msg->num))
 constexpr uint32_t kImmData = 0x123;
+constexpr uint32_t kPagePrefix = 0x1;  // immediate data (kPagePrefix << 16) | page group
+constexpr uint32_t kGenPrefix = 0x2;   // immediate data (kGenPrefix << 16) | generation
+constexpr uint32_t kCrcPrefix = 0x4;   // immediate data (kCrcPrefix << 16) | page group, checksummed
 
-struct CUDARegion {
-  uint64_t addr;
-  uint64_t size;
-  uint64_t key;
+/**
+ * @brief Command line of the benchmark
+ */
+struct Options {
+  std::string mode = "transfer";
+  std::string pairing = "node";  ///< how ranks pair up (see Pairing)
+  size_t group = 1;       ///< pages per immediate (pages, crc)
+  size_t gens = 2;        ///< receive generations (gens)
+  size_t consume_us = 0;  ///< simulated consumer work per round (gens)
+  size_t rounds = 100;    ///< pushes per dirty ratio (delta)
 };
 
+/** @brief Dirty ratios benchmarked by the delta mode, in percent */
+constexpr size_t kDirtyRatios[] = {0, 1, 10, 100};
+
 struct Message {
   int rank;
   size_t num;  // number of items
   uint64_t seed;
 
-  CUDARegion &operator[](int i) {
-    auto base = (CUDARegion *)((char *)this + sizeof(*this));
+  Region &operator[](int i) {
+    auto base = (Region *)((char *)this + sizeof(*this));
     return base[i];
   }
 };
@@ -50,13 +73,17 @@ class Peer : private NoCopy {
     auto &loc = GPUloc::Get();
     auto local_rank = mpi.GetLocalRank();
     auto &affinity = loc.GetGPUAffinity()[local_rank];
-    auto cpu = affinity.cores[local_rank]->logical_index;
-    auto efa = affinity.efas[local_rank].second;
+    ASSERT(!affinity.efas.empty());
+    // GPUs sharing a PCIe switch spread over its NICs
+    auto efa = affinity.efas[local_rank % affinity.efas.size()].second;
     total_bw_ = efa->nic->link_attr->speed;
+    // only this thread is pinned
+    auto cpu = PickCPU(loc, local_rank);
 
-    std::cout << "[RANK:" << rank << "] GPU(" << local_rank << ") CPU(" << cpu << ")" << std::endl;
+    std::cout << "[RANK:" << rank << "] GPU(" << local_rank << ") CPU(" << cpu << ") EFA(" << efa->domain_attr->name << ") PEER(" << peer << ")"
+              << std::endl;
     cudaSetDevice(local_rank);
-    Taskset::Set(cpu);
+    Taskset::SetThread(cpu);
     net_.Open(efa);
     conn_ = Connect(net_, peer);
     ASSERT(!!conn_);
@@ -67,6 +94,33 @@ class Peer : private NoCopy {
   }
 
  protected:
+  /**
+   * @brief Choose the CPU of a rank's event loop
+   *
+   * A rank the launcher bound to part of its NUMA node, e.g. with the
+   * --cpu-bind=mask_cpu flags of gpuloc plan, keeps the first CPU it
+   * inherited, which is the plan's main-loop core. An unbound rank takes a
+   * whole physical core away from the interrupts of every NIC on the node,
+   * in the slot Planner would give it: ranks sharing a NUMA node take
+   * consecutive slots. Both agree as long as NVML orders GPUs by PCI address.
+   *
+   * @param loc GPU locality
+   * @param local_rank Rank on this node, also its GPU index
+   * @return OS index of the CPU
+   */
+  inline static int PickCPU(GPUloc &loc, size_t local_rank) {
+    auto &gpus = loc.GetGPUAffinity();
+    auto &affinity = gpus[local_rank];
+    auto cores = CoreAllocator(affinity.cores, loc.GetEFAs(affinity.numanode));
+    std::set<int> local;
+    for (auto &core : cores.GetCores()) local.insert(core.pus.begin(), core.pus.end());
+    auto inherited = Taskset::Get();
+    if (inherited.size() < local.size() and std::includes(local.begin(), local.end(), inherited.begin(), inherited.end())) return inherited.front();
+    size_t slot = 0;
+    for (size_t r = 0; r < local_rank; ++r) slot += gpus[r].numanode == affinity.numanode;
+    return cores.Allocate(slot).front();
+  }
+
   inline static Conn *Connect(Net &net, int peer) {
     auto &mpi = MPI::Get();
     int rank = mpi.GetWorldRank();
@@ -78,19 +132,33 @@ class Peer : private NoCopy {
   }
 
   inline static std::vector<uint8_t> RandBuffer(uint64_t seed, size_t size) {
-    ASSERT(size % sizeof(uint64_t) == 0);
     std::vector<uint8_t> buf(size);
-    std::mt19937_64 gen(seed);
-    std::uniform_int_distribution<uint64_t> dist;
-    for (size_t i = 0; i < size; i += sizeof(uint64_t)) *(uint64_t *)(buf.data() + i) = dist(gen);
+    Philox::Fill(seed, buf.data(), size);
     return buf;
   }
 
-  inline static bool Verify(char *cuda_buffer, uint64_t seed, size_t size) {
-    auto expected = RandBuffer(seed, size);
-    auto actual = std::vector<uint8_t>(size, 0);
-    CUDA_CHECK(cudaMemcpy(actual.data(), (uint8_t *)cuda_buffer, size, cudaMemcpyDeviceToHost));
-    return expected == actual;
+  /**
+   * @brief Per-page checksums of the data generated from a seed
+   *
+   * The writer fills its buffer with RandBuffer(seed), so the reader only
+   * needs these to verify a round instead of a second copy of the data.
+   */
+  inline std::vector<uint64_t> Checksums(uint64_t seed) const {
+    auto expected = RandBuffer(seed, size_);
+    return PageHash::Pages(expected.data(), page_size_, num_pages_);
+  }
+
+  /**
+   * @brief Count pages of a host copy whose checksum differs from the expected one
+   * @param data Host copy of page_size * num_pages bytes
+   * @param expected Checksums from Checksums()
+   * @return Number of corrupted pages
+   */
+  inline size_t Verify(const uint8_t *data, const std::vector<uint64_t> &expected) const {
+    auto actual = PageHash::Pages(data, page_size_, num_pages_);
+    size_t bad = 0;
+    for (size_t p = 0; p < num_pages_; ++p) bad += actual[p] != expected[p];
+    return bad;
   }
 
  protected:
@@ -101,18 +169,21 @@ class Peer : private NoCopy {
   size_t num_pages_;
   size_t size_;
   size_t total_bw_;
+  bool verbose_ = MPI::Get().GetWorldRank() == 0;  // only one rank draws progress
   std::mt19937_64 rng_{0x123456789UL};
 };
 
 class Writer : public Peer {
  public:
   Writer() = delete;
-  Writer(int peer, size_t page_size, size_t num_pages) : Peer(peer, page_size, num_pages) {
-    auto buffer = RandBuffer(peer_seed_, size_);
-    auto cuda_buffer = (char *)conn_->GetWriteBuffer().GetData();
-    CUDA_CHECK(cudaMemcpy(cuda_buffer, buffer.data(), size_, cudaMemcpyHostToDevice));
-  }
+  Writer(int peer, size_t page_size, size_t num_pages) : Peer(peer, page_size, num_pages) {}
 
+  /** @brief Payload bytes written to the reader so far */
+  inline size_t GetBytes() const noexcept { return bytes_; }
+
+  /**
+   * @brief Receive the reader's regions and seed, then fill the write buffer from the seed
+   */
   Coro<> Handshake() {
     auto [buf, size] = co_await conn_->Recv();
     auto resp = (Message *)buf;
@@ -123,50 +194,200 @@ class Writer : public Peer {
     for (size_t i = 0; i < resp->num; ++i) {
       peer_regions_[i] = (*resp)[i];
     }
+
+    auto start = std::chrono::steady_clock::now();
+    host_ = RandBuffer(peer_seed_, size_);
+    auto elapse = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    auto cuda_buffer = (char *)conn_->GetWriteBuffer().GetData();
+    CUDA_CHECK(cudaMemcpy(cuda_buffer, host_.data(), size_, cudaMemcpyHostToDevice));
+    std::cout << fmt::format("rand={} size={} fill={:.2f}ms", Philox::Name(), size_, elapse) << std::endl;
   }
 
   Coro<> Write(size_t repeat) {
     auto total_ops = repeat * peer_regions_.size() * num_pages_;
-    auto progress = Progress(total_ops, total_bw_);
+    auto progress = Progress(total_ops, total_bw_, verbose_);
     size_t ops = 0;
-    size_t sent = 0;
     for (size_t i = 0; i < repeat; ++i) {
-      co_await WriteOne(progress, ops, sent);
+      co_await WriteOne(progress, ops);
     }
+    auto &pipeline = conn_->GetPipeline();
+    std::cout << fmt::format("\nsegment={} depth={} rtt={}ns", pipeline.segment, pipeline.depth, conn_->GetRTT().count()) << std::endl;
   }
 
-  Coro<> WriteOne(Progress &progress, size_t &ops, size_t &sent) {
-    const size_t batch_size = 8;
-    auto cuda_buffer = conn_->GetWriteBuffer().GetData();
-    std::deque<Future<Coro<size_t>>> futs;
-    for (auto &region : peer_regions_) {
-      for (size_t i = 0; i < num_pages_; ++i) {
-        /**
-         * TODO: still have bug here. (core dump). However, using pipeline
-         * can saturate EFA bandwidth. Example output:
-         *
-         * [12.126s] ops=557500/2500000 bytes=146145280000/655360000000 bw=96.419Gbps(96.4)
-         */
-        while (futs.size() >= batch_size) {
-          auto &fut = futs.front();
-          co_await fut;
-          ++ops;
-          futs.pop_front();
-        }
-
-        auto base = (char *)cuda_buffer + i * page_size_;
-        auto addr = region.addr + i * page_size_;
-        auto key = region.key;
-        auto is_final = (i == num_pages_ - 1);
-        auto imm_data = is_final ? kImmData : 0;
-        futs.emplace_back(Future(conn_->Write(base, page_size_, addr, key, imm_data)));
-        ++sent;
+  /**
+   * @brief Write rounds page by page and wait for the reader to finish each one
+   * @param repeat Number of rounds
+   * @param group Pages announced by one immediate
+   */
+  Coro<> WritePages(size_t repeat, size_t group) {
+    auto total_ops = repeat * peer_regions_.size() * num_pages_;
+    auto progress = Progress(total_ops, total_bw_, verbose_);
+    auto cuda_buffer = (const char *)conn_->GetWriteBuffer().GetData();
+    size_t ops = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+      for (auto &region : peer_regions_) {
+        co_await conn_->TransferPages(cuda_buffer, page_size_, num_pages_, region, kPagePrefix, group);
+        ops += num_pages_;
+        bytes_ += size_;
+      }
+      // the reader reuses its buffer, so the next round waits for its ack
+      co_await conn_->Recv();
+      progress.Print(std::chrono::high_resolution_clock::now(), page_size_, ops);
+    }
+  }
+
+  /**
+   * @brief Write rounds page by page with a CRC32C trailer the reader validates against
+   *
+   * The CRC32C of every page goes into a trailer right behind the pages. The
+   * trailer is written and completed before the pages, so it is in place when
+   * the first page is announced. The checksums of the next round are computed
+   * on a worker thread while the current round is on the wire.
+   *
+   * The first half of the rounds is a baseline: the same pages and group
+   * without trailer or validation. The overhead is the bandwidth the checked
+   * rounds lose against it, which covers the trailer write and the reader's
+   * per-page check before its ack.
+   *
+   * @param repeat Number of rounds, baseline included
+   * @param group Pages announced by one immediate
+   */
+  Coro<> WriteChecked(size_t repeat, size_t group) {
+    using clock = std::chrono::steady_clock;
+    auto &region = peer_regions_[0];
+    auto cuda_buffer = (char *)conn_->GetWriteBuffer().GetData();
+    auto trailer_size = num_pages_ * sizeof(uint32_t);
+    ASSERT(size_ + trailer_size <= conn_->GetWriteBuffer().GetSize() and size_ + trailer_size <= region.size);
+    std::vector<uint32_t> trailers[2] = {std::vector<uint32_t>(num_pages_), std::vector<uint32_t>(num_pages_)};
+    auto checksum = [this](std::vector<uint32_t> &out) {
+      auto start = clock::now();
+      Crc32c::Pages(host_.data(), page_size_, num_pages_, out.data());
+      return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    auto progress = Progress(repeat * num_pages_, total_bw_, verbose_);
+    auto baseline = repeat / 2, checked = repeat - baseline;
+    size_t ops = 0;
+    auto start = clock::now();
+    for (size_t i = 0; i < baseline; ++i) {
+      co_await conn_->TransferPages(cuda_buffer, page_size_, num_pages_, region, kCrcPrefix, group);
+      co_await conn_->Recv();
+      ops += num_pages_;
+      bytes_ += size_;
+      progress.Print(std::chrono::high_resolution_clock::now(), page_size_, ops);
+    }
+    auto plain = std::chrono::duration<double>(clock::now() - start).count();
+
+    auto pending = std::async(std::launch::async, checksum, std::ref(trailers[0]));
+    double crc = 0, stall = 0;
+    start = clock::now();
+    for (size_t i = 0; i < checked; ++i) {
+      auto wait = clock::now();
+      crc += pending.get();
+      stall += std::chrono::duration<double>(clock::now() - wait).count();
+      auto &trailer = trailers[i % 2];
+      CUDA_CHECK(cudaMemcpy(cuda_buffer + size_, trailer.data(), trailer_size, cudaMemcpyHostToDevice));
+      if (i + 1 < checked) pending = std::async(std::launch::async, checksum, std::ref(trailers[(i + 1) % 2]));
+      co_await conn_->Write(cuda_buffer + size_, trailer_size, region.addr + size_, region.key);
+      co_await conn_->TransferPages(cuda_buffer, page_size_, num_pages_, region, kCrcPrefix, group);
+      // the reader reuses its buffer, so the next round waits for its ack
+      co_await conn_->Recv();
+      ops += num_pages_;
+      bytes_ += size_ + trailer_size;
+      progress.Print(std::chrono::high_resolution_clock::now(), page_size_, ops);
+    }
+    auto elapse = std::chrono::duration<double>(clock::now() - start).count();
+    auto plain_bw = size_ * baseline * Progress::Gb / plain;
+    auto checked_bw = size_ * checked * Progress::Gb / elapse;
+    std::cout << fmt::format("\ncrc={} group={} pages_bw={:.2f}Gbps crc_bw={:.2f}Gbps overhead={:.2f}% hash={:.2f}GB/s hash_stall={:.3f}ms",
+                             Crc32c::Name(), group, plain_bw, checked_bw, 100.0 * (1 - checked_bw / plain_bw), size_ * checked / crc / 1e9,
+                             stall * 1e3)
+              << std::endl;
+  }
+
+  /**
+   * @brief Write round i into generation i mod K, bounded by reader credits
+   *
+   * The reader advertises one region per generation and returns a credit
+   * after it released one, so a generation is never overwritten while it is
+   * being consumed. The writer starts with K credits.
+   *
+   * @param repeat Number of rounds
+   */
+  Coro<> WriteGenerations(size_t repeat) {
+    auto gens = peer_regions_.size();
+    auto total_ops = repeat * num_pages_;
+    auto progress = Progress(total_ops, total_bw_, verbose_);
+    auto cuda_buffer = (const char *)conn_->GetWriteBuffer().GetData();
+    size_t ops = 0, credits = gens, stalls = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+      if (credits == 0) {
+        ++stalls;
+        co_await conn_->Recv();
+        ++credits;
       }
+      --credits;
+      auto gen = i % gens;
+      co_await conn_->Transfer(cuda_buffer, size_, peer_regions_[gen], (kGenPrefix << 16) | gen);
+      ops += num_pages_;
+      bytes_ += size_;
+      progress.Print(std::chrono::high_resolution_clock::now(), page_size_, ops);
     }
+    std::cout << fmt::format("\ngens={} credit_stalls={}/{}", gens, stalls, repeat) << std::endl;
+  }
+
+  /**
+   * @brief Push a region with DeltaSync at several dirty ratios
+   *
+   * Every push changes one word in a random set of pages, sends the delta and
+   * waits for the reader's ack, so push time covers the commit.
+   *
+   * @param rounds Pushes per ratio
+   */
+  Coro<> WriteDelta(size_t rounds) {
+    auto delta = DeltaSync(conn_, page_size_, num_pages_);
+    auto &region = peer_regions_[0];
+    auto &state = delta.GetState();
+    auto init = RandBuffer(rng_(), size_);
+    std::memcpy(state.data(), init.data(), size_);
+    co_await delta.Push(region);
+    co_await conn_->Recv();
 
-    for (auto &fut : futs) {
-      co_await fut;
-      ++ops;
+    std::cout << fmt::format("# hash={} page_size={} num_pages={}", PageHash::Name(), page_size_, num_pages_) << std::endl;
+    std::cout << fmt::format("{:>8} {:>8} {:>8} {:>12} {:>12} {:>12} {:>10} {:>12}", "dirty(%)", "pages", "runs", "hash(us)", "hash(GB/s)",
+                             "wire(B)", "saved(%)", "push(us)")
+              << std::endl;
+    std::vector<size_t> pages(num_pages_);
+    std::iota(pages.begin(), pages.end(), 0);
+    for (auto ratio : kDirtyRatios) {
+      DeltaSync::Stats total;
+      auto dirty = num_pages_ * ratio / 100;
+      for (size_t i = 0; i < rounds; ++i) {
+        std::shuffle(pages.begin(), pages.end(), rng_);
+        for (size_t k = 0; k < dirty; ++k) ++*(uint64_t *)(state.data() + pages[k] * page_size_);
+        auto stats = co_await delta.Push(region);
+        co_await conn_->Recv();
+        total.dirty += stats.dirty;
+        total.runs += stats.runs;
+        total.wire += stats.wire;
+        bytes_ += stats.wire;
+        total.hash += stats.hash;
+        total.push += stats.push;
+      }
+      auto hash_us = total.hash.count() / 1e3 / rounds;
+      auto wire = total.wire / rounds;
+      std::cout << fmt::format("{:>8} {:>8} {:>8} {:>12.2f} {:>12.3f} {:>12} {:>10.2f} {:>12.2f}", ratio, total.dirty / rounds, total.runs / rounds,
+                               hash_us, size_ / hash_us / 1e3, wire, 100.0 * (1.0 - (double)wire / size_), total.push.count() / 1e3 / rounds)
+                << std::endl;
+    }
+  }
+
+  Coro<> WriteOne(Progress &progress, size_t &ops) {
+    auto cuda_buffer = (const char *)conn_->GetWriteBuffer().GetData();
+    for (auto &region : peer_regions_) {
+      co_await conn_->Transfer(cuda_buffer, size_, region, kImmData);
+      ops += num_pages_;
+      bytes_ += size_;
     }
     auto now = std::chrono::high_resolution_clock::now();
     progress.Print(now, page_size_, ops);
@@ -174,13 +395,33 @@ class Writer : public Peer {
 
  private:
   uint64_t peer_seed_;
-  std::vector<CUDARegion> peer_regions_;
+  std::vector<uint8_t> host_;  // host copy of the write buffer
+  std::vector<Region> peer_regions_;
+  size_t bytes_ = 0;
 };
 
 class Reader : public Peer {
  public:
   Reader() = delete;
-  Reader(int peer, size_t page_size, size_t num_pages) : Peer(peer, page_size, num_pages) {}
+  Reader(int peer, size_t page_size, size_t num_pages, size_t gens = 1) : Peer(peer, page_size, num_pages), gens_{gens} {
+    ASSERT(gens_ >= 1 and gens_ * size_ <= conn_->GetReadBuffer().GetSize());
+    ASSERT(sizeof(Message) + gens_ * sizeof(Region) <= kBufferSize);
+  }
+
+  /**
+   * @brief Route immediates starting with prefix to a fresh page tracker
+   *
+   * Must run before Handshake(): the writer starts as soon as it has the
+   * regions, and an immediate reaped before the subscription is parked as an
+   * early completion that never reaches the tracker.
+   *
+   * @param prefix Upper 16 bits of the page immediates
+   * @param group Pages announced by one immediate
+   */
+  void Subscribe(uint32_t prefix, size_t group) {
+    arrivals_ = std::make_unique<Arrivals>(num_pages_, group);
+    IO::Get().Subscribe(prefix, arrivals_.get());
+  }
 
   Coro<> Handshake() {
     auto req = Alloc(conn_);
@@ -196,6 +437,174 @@ class Reader : public Peer {
 
   Coro<> ReadOne() { co_await conn_->Read(kImmData); }
 
+  /**
+   * @brief Read rounds and verify every one against per-page checksums
+   *
+   * Each round is copied to one of two host snapshots and hashed on worker
+   * threads while the event loop waits for the next round, so only the
+   * device-to-host copy stays on the critical path. The writer sends the same
+   * data every round, so a snapshot taken while the next round lands is still
+   * comparable.
+   *
+   * @param repeat Number of rounds
+   */
+  Coro<> ReadVerify(size_t repeat) {
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now();
+    auto expected = Checksums(seed_);
+    auto setup = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    auto cuda_buffer = (const char *)conn_->GetReadBuffer().GetData();
+    std::vector<uint8_t> snapshots[2] = {std::vector<uint8_t>(size_), std::vector<uint8_t>(size_)};
+    std::future<size_t> pending;
+    size_t bad = 0;
+    start = clock::now();
+    for (size_t i = 0; i < repeat; ++i) {
+      co_await conn_->Read(kImmData);
+      auto &snapshot = snapshots[i % 2];
+      // the other snapshot may still be hashed; this one was released by the previous get()
+      CUDA_CHECK(cudaMemcpy(snapshot.data(), cuda_buffer, size_, cudaMemcpyDeviceToHost));
+      if (pending.valid()) bad += pending.get();
+      pending = std::async(std::launch::async, [this, &snapshot, &expected] { return Verify(snapshot.data(), expected); });
+    }
+    if (pending.valid()) bad += pending.get();
+    auto elapse = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << fmt::format("verify rounds={} bad_pages={} checksums={:.2f}ms bw={:.3f}Gbps", repeat, bad, setup, size_ * repeat * Progress::Gb / elapse)
+              << std::endl;
+  }
+
+  /**
+   * @brief Consume every round page by page in arrival order
+   *
+   * Reports how long after releasing the writer the first and the last page
+   * of a round became usable; the gap is the time a consumer gains over
+   * waiting for the whole round. Subscribe(kPagePrefix, group) must have run
+   * before the handshake.
+   *
+   * @param repeat Number of rounds
+   * @param group Pages announced by one immediate
+   */
+  Coro<> ReadPages(size_t repeat, size_t group) {
+    using clock = std::chrono::steady_clock;
+    auto &arrivals = *arrivals_;
+    std::chrono::duration<double, std::micro> first{0}, last{0};
+    size_t dups = 0;
+    char ack = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+      auto start = clock::now();
+      std::vector<bool> seen(num_pages_, false);
+      size_t n = 0;
+      while (auto page = co_await arrivals.Next()) {
+        if (n++ == 0) first += clock::now() - start;
+        if (seen[*page]) ++dups;
+        seen[*page] = true;
+      }
+      last += clock::now() - start;
+      arrivals.Reset();
+      co_await conn_->Send(&ack, sizeof(ack));
+    }
+    IO::Get().Unsubscribe(kPagePrefix);
+    std::cout << fmt::format("group={} first_page={:.2f}us last_page={:.2f}us dups={}", group, first.count() / repeat, last.count() / repeat, dups)
+              << std::endl;
+  }
+
+  /**
+   * @brief Validate every page against the writer's CRC32C trailer as it lands
+   *
+   * The trailer is staged once per round when the first page is announced;
+   * each page is then copied to the host and checked while later pages are
+   * still in flight. Reports corrupted pages and how far validation trails
+   * the last page of a round. The first half of the rounds is the writer's
+   * baseline and is acked without validation. Subscribe(kCrcPrefix, group)
+   * must have run before the handshake.
+   *
+   * @param repeat Number of rounds, baseline included
+   * @param group Pages announced by one immediate
+   */
+  Coro<> ReadChecked(size_t repeat, size_t group) {
+    using clock = std::chrono::steady_clock;
+    auto &arrivals = *arrivals_;
+    auto cuda_buffer = (const char *)conn_->GetReadBuffer().GetData();
+    std::vector<uint32_t> trailer(num_pages_);
+    std::vector<uint8_t> page(page_size_);
+    std::chrono::duration<double, std::micro> check{0}, round{0};
+    size_t bad = 0;
+    char ack = 0;
+    auto baseline = repeat / 2, checked = repeat - baseline;
+    for (size_t i = 0; i < baseline; ++i) {
+      while (co_await arrivals.Next()) {
+      }
+      arrivals.Reset();
+      co_await conn_->Send(&ack, sizeof(ack));
+    }
+    for (size_t i = 0; i < checked; ++i) {
+      auto start = clock::now();
+      size_t n = 0;
+      while (auto p = co_await arrivals.Next()) {
+        auto t = clock::now();
+        if (n++ == 0) CUDA_CHECK(cudaMemcpy(trailer.data(), cuda_buffer + size_, trailer.size() * sizeof(uint32_t), cudaMemcpyDeviceToHost));
+        CUDA_CHECK(cudaMemcpy(page.data(), cuda_buffer + *p * page_size_, page_size_, cudaMemcpyDeviceToHost));
+        bad += Crc32c::Run(page.data(), page_size_) != trailer[*p];
+        check += clock::now() - t;
+      }
+      round += clock::now() - start;
+      arrivals.Reset();
+      co_await conn_->Send(&ack, sizeof(ack));
+    }
+    IO::Get().Unsubscribe(kCrcPrefix);
+    std::cout << fmt::format("crc={} rounds={} bad_pages={} check={:.2f}us/round ({:.2f}% of round)", Crc32c::Name(), checked, bad,
+                             check.count() / checked, 100.0 * check.count() / round.count())
+              << std::endl;
+  }
+
+  /**
+   * @brief Apply DeltaSync pushes: wait for each commit, decode its manifest and ack
+   * @param pushes Number of pushes, including the initial full one
+   */
+  Coro<> ReadDelta(size_t pushes) {
+    auto cuda_buffer = (const char *)conn_->GetReadBuffer().GetData();
+    std::vector<char> manifest(Manifest::MaxSize(num_pages_));
+    size_t errors = 0;
+    char ack = 0;
+    for (size_t v = 0; v < pushes; ++v) {
+      co_await conn_->Read(DeltaSync::Commit(v));
+      CUDA_CHECK(cudaMemcpy(manifest.data(), cuda_buffer + size_, manifest.size(), cudaMemcpyDeviceToHost));
+      Manifest::Header header;
+      auto pages = Manifest::Decode(manifest.data(), header);
+      if (header.version != v or header.dirty != pages.size() or (v == 0 and pages.size() != num_pages_)) ++errors;
+      co_await conn_->Send(&ack, sizeof(ack));
+    }
+    std::cout << fmt::format("delta pushes={} errors={}", pushes, errors) << std::endl;
+  }
+
+  /**
+   * @brief Consume generation i mod K of every round, then return its credit
+   *
+   * The consumer is simulated by spinning for consume_us, as a CPU-bound
+   * consumer would block this event loop. Once it is slower than the wire the
+   * writer runs out of credits and the throughput drops to the consumer's.
+   * The last K rounds return no credit: the writer only waits for one before
+   * round K onwards, so it receives exactly repeat - K credits.
+   *
+   * @param repeat Number of rounds
+   * @param consume_us Work per round in microseconds
+   */
+  Coro<> ReadGenerations(size_t repeat, size_t consume_us) {
+    using clock = std::chrono::steady_clock;
+    char credit = 0;
+    auto start = clock::now();
+    for (size_t i = 0; i < repeat; ++i) {
+      auto gen = i % gens_;
+      co_await conn_->Read((kGenPrefix << 16) | gen);
+      auto until = clock::now() + std::chrono::microseconds(consume_us);
+      while (clock::now() < until) {
+      }
+      if (i + gens_ < repeat) co_await conn_->Send(&credit, sizeof(credit));
+    }
+    auto elapse = std::chrono::duration<double>(clock::now() - start).count();
+    std::cout << fmt::format("gens={} consume={}us rounds={} bw={:.3f}Gbps", gens_, consume_us, repeat, size_ * repeat * Progress::Gb / elapse)
+              << std::endl;
+  }
+
  private:
   inline Message *Alloc(Conn *conn) {
     auto &mpi = MPI::Get();
@@ -206,48 +615,115 @@ class Reader : public Peer {
     auto cuda_mr = cuda_buffer.GetMR();
     auto cuda_key = cuda_mr->key;
     auto &header = *data;
-    auto &payload = (*data)[0];
 
+    // a single generation keeps advertising the whole buffer
     header.rank = mpi.GetWorldRank();
-    header.num = 1;
-    header.seed = rng_();
-    payload.addr = (uint64_t)cuda_data;
-    payload.size = kMemoryRegionSize;
-    payload.key = cuda_key;
+    header.num = gens_;
+    header.seed = seed_ = rng_();
+    for (size_t g = 0; g < gens_; ++g) {
+      auto &payload = (*data)[g];
+      payload.addr = (uint64_t)cuda_data + g * size_;
+      payload.size = gens_ == 1 ? kMemoryRegionSize : size_;
+      payload.key = cuda_key;
+    }
     return data;
   }
+
+ private:
+  size_t gens_;
+  uint64_t seed_ = 0;  // seed the writer generates its buffer from
+  std::unique_ptr<Arrivals> arrivals_;
 };
 
-Coro<> StartWriter(size_t page_size, size_t num_pages, size_t repeat) {
-  auto &mpi = MPI::Get();
-  ASSERT(mpi.GetWorldRank() == 0);
-  auto peer = 1;
+/**
+ * @brief Run the writer side of a mode
+ * @return Coroutine yielding the writer's bandwidth in Gbps, handshake excluded
+ */
+Coro<double> StartWriter(int peer, size_t page_size, size_t num_pages, size_t repeat, const Options &opts) {
   auto writer = Writer(peer, page_size, num_pages);
   co_await writer.Handshake();
-  co_await writer.Write(repeat);
+  auto start = std::chrono::steady_clock::now();
+  if (opts.mode == "pages") {
+    co_await writer.WritePages(repeat, opts.group);
+  } else if (opts.mode == "crc") {
+    co_await writer.WriteChecked(repeat, opts.group);
+  } else if (opts.mode == "gens") {
+    co_await writer.WriteGenerations(repeat);
+  } else if (opts.mode == "delta") {
+    co_await writer.WriteDelta(opts.rounds);
+  } else {
+    co_await writer.Write(repeat);
+  }
+  auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  co_return writer.GetBytes() * Progress::Gb / elapse;
 }
 
-Coro<> StartReader(size_t page_size, size_t num_pages, size_t repeat) {
-  auto &mpi = MPI::Get();
-  ASSERT(mpi.GetWorldRank() == 1);
-  auto peer = 0;
-  auto reader = Reader(peer, page_size, num_pages);
+Coro<> StartReader(int peer, size_t page_size, size_t num_pages, size_t repeat, const Options &opts) {
+  auto reader = Reader(peer, page_size, num_pages, opts.mode == "gens" ? opts.gens : 1);
+  // page immediates may arrive as soon as the writer has the handshake
+  if (opts.mode == "pages") reader.Subscribe(kPagePrefix, opts.group);
+  if (opts.mode == "crc") reader.Subscribe(kCrcPrefix, opts.group);
   co_await reader.Handshake();
-  co_await reader.Read(repeat);
+  if (opts.mode == "pages") {
+    co_await reader.ReadPages(repeat, opts.group);
+  } else if (opts.mode == "crc") {
+    co_await reader.ReadChecked(repeat, opts.group);
+  } else if (opts.mode == "gens") {
+    co_await reader.ReadGenerations(repeat, opts.consume_us);
+  } else if (opts.mode == "delta") {
+    co_await reader.ReadDelta(1 + std::size(kDirtyRatios) * opts.rounds);
+  } else if (opts.mode == "verify") {
+    co_await reader.ReadVerify(repeat);
+  } else {
+    co_await reader.Read(repeat);
+  }
 }
 
+/**
+ * usage: batch [--pairing node|half] [transfer | verify | pages [group] | crc [group] | gens [K] [consume_us] | delta [rounds]]
+ *
+ * transfer (default): every round goes out with Conn::Transfer and only the
+ * last segment carries kImmData.
+ * verify: transfer, and the reader checks every round against per-page
+ * checksums of the writer's seed.
+ * pages: every group of pages carries its own immediate and the reader
+ * consumes pages as they land.
+ * crc: pages mode with a CRC32C per page in a trailer; the reader validates
+ * every page as it lands.
+ * gens: the reader's buffer is split into K generations; round i lands in
+ * generation i mod K and the writer waits for a credit once all K are in use.
+ * delta: DeltaSync pushes at 0/1/10/100% dirty pages, reporting hashing cost
+ * and bytes saved on the wire.
+ *
+ * Any number of ranks per node is supported, each driving its own GPU and
+ * NIC; --pairing picks the writer/reader pairs (see Pairing). Rank 0 prints
+ * every writer's bandwidth and the aggregate per node at the end.
+ */
 int main(int argc, char *argv[]) {
-  auto &mpi = MPI::Get();
-  // assumption: 2 nodes and nproc per ndoe = 1
-  ASSERT(mpi.GetWorldSize() == 2);
-  ASSERT(mpi.GetLocalSize() == 1);
-
   constexpr size_t page_size = 256 << 10;  // 256k
   constexpr size_t num_pages = 250;
   constexpr size_t repeat = 10000;
-  if (mpi.GetWorldRank() == 0) {
-    Run(StartWriter(page_size, num_pages, repeat));
+  Options opts;
+  std::vector<std::string> args(argv + 1, argv + argc);
+  if (args.size() >= 2 and args[0] == "--pairing") {
+    opts.pairing = args[1];
+    args.erase(args.begin(), args.begin() + 2);
+  }
+  auto nargs = args.size();
+  if (nargs > 0) opts.mode = args[0];
+  if ((opts.mode == "pages" or opts.mode == "crc") and nargs > 1) opts.group = std::stoul(args[1]);
+  if (opts.mode == "gens" and nargs > 1) opts.gens = std::stoul(args[1]);
+  if (opts.mode == "gens" and nargs > 2) opts.consume_us = std::stoul(args[2]);
+  if (opts.mode == "delta" and nargs > 1) opts.rounds = std::stoul(args[1]);
+  if (opts.mode != "transfer" and opts.mode != "verify" and opts.mode != "pages" and opts.mode != "crc" and opts.mode != "gens" and opts.mode != "delta") {
+    throw std::invalid_argument(fmt::format("unknown mode {}", opts.mode));
+  }
+  auto pair = Pairing::Get(opts.pairing);
+  double bw = 0;
+  if (pair.role == Pairing::kWriter) {
+    bw = Run(StartWriter(pair.peer, page_size, num_pages, repeat, opts));
   } else {
-    Run(StartReader(page_size, num_pages, repeat));
+    Run(StartReader(pair.peer, page_size, num_pages, repeat, opts));
   }
+  ReportBandwidth(bw);
 }
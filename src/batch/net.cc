@@ -4,7 +4,7 @@ Conn *Net::Connect(const char *remote) {
   fi_addr_t addr = FI_ADDR_UNSPEC;
   EXPECT(fi_av_insert(av_, remote, 1, &addr, 0, nullptr), 1);
   auto key = Addr2Str(remote);
-  auto conn = std::make_unique<Conn>(ep_, domain_, addr);
+  auto conn = std::make_unique<Conn>(ep_, domain_, addr, info_);
   auto raw_conn = conn.get();
   conns_.emplace(key, std::move(conn));
   return raw_conn;
@@ -14,6 +14,7 @@ void Net::Open(struct fi_info *info) {
   struct fi_av_attr av_attr{};
   struct fi_cq_attr cq_attr{};
 
+  info_ = info;
   CHECK(fi_fabric(info->fabric_attr, &fabric_, nullptr));
   CHECK(fi_domain(fabric_, info, &domain_, nullptr));
 
@@ -6,10 +6,74 @@ DIR="$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
 sqsh="${DIR}/../../efa+latest.sqsh"
 mount="/fsx:/fsx"
 binary="${DIR}/../../build/src/batch/batch"
+gpuloc="${DIR}/../../build/src/gpuloc/gpuloc"
+
+# plan CPU and memory binding on one compute node; all nodes share the topology
+bind=$(srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --nodes=1 --ntasks=1 \
+  "${gpuloc}" plan 1 1 srun)
 
 srun --container-image "${sqsh}" \
   --container-mounts "${mount}" \
   --container-name efa \
   --mpi=pmix \
-  --ntasks-per-node=1 \
+  ${bind} \
   "${binary}"
+
+# one rank per GPU, each writing through its own NIC to the same local rank on the other node
+bind=$(srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --nodes=1 --ntasks=1 \
+  "${gpuloc}" plan 8 1 srun)
+
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  ${bind} \
+  "${binary}" --pairing node
+
+# per-page arrival notifications
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  "${binary}" pages 1
+
+# K generations with writer-side credits; the second run is consumer bound
+for consume_us in 0 20000; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --ntasks-per-node=1 \
+    "${binary}" gens 4 "${consume_us}"
+done
+
+# dirty-page delta sync at 0/1/10/100% dirty
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  "${binary}" delta 100
+
+# transfer with per-round checksum verification on the reader
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  "${binary}" verify
+
+# per-page CRC32C trailer validated on arrival
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  "${binary}" crc 1
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief Variable-size all-to-all among the first group ranks of a Comm
+ *
+ * Plan() exchanges the per-peer byte counts once: every rank writes its row of
+ * the count matrix into every peer, so each sender can compute where its shard
+ * starts inside each receiver. Run() then writes every shard straight into the
+ * receiver's registered region at that offset, tagged with
+ * Comm::Imm(kTagAlltoallv, 1 + parity, source), and waits for one immediate
+ * from each source.
+ *
+ * Peers are visited in a shifted order (rank + 1, rank + 2, ...) with a small
+ * number of writes in flight, so in every round each receiver is targeted by a
+ * single sender instead of all of them at once.
+ *
+ * The receive region is double-buffered by step parity. A rank only starts
+ * step s + 2 after it received step s + 1 from everyone, and every peer sends
+ * step s + 1 only after it finished step s, so slot s is never overwritten
+ * while its owner still reads it. Zero-byte shards are sent as zero-length
+ * writes so this holds for sparse traffic too.
+ */
+class Alltoallv : private NoCopy {
+ public:
+  /** @brief Shard writes kept in flight */
+  inline constexpr static size_t kDepth = 4;
+
+  /**
+   * @brief Allocate and expose memory (collective over the whole Comm)
+   * @param comm Connected group
+   * @param group Number of participating ranks (ranks >= group only take part in setup)
+   * @param send_size Send buffer size in bytes
+   * @param recv_size Receive capacity per step in bytes
+   */
+  Alltoallv(Comm &comm, int group, size_t send_size, size_t recv_size)
+      : comm_{comm},
+        group_{group},
+        send_{send_size},
+        recv_{2 * recv_size},
+        counts_{sizeof(uint64_t) * group * group},
+        recv_size_{recv_size} {
+    ASSERT(group >= 1 and group <= comm.GetSize());
+    recvs_ = comm_.Expose(recv_);
+    matrices_ = comm_.Expose(counts_);
+  }
+
+  /** @brief Check whether this rank takes part */
+  inline bool IsMember() const noexcept { return comm_.GetRank() < group_; }
+  /** @brief Get the send buffer; the shard for peer j starts at GetSendDispls()[j] */
+  inline Memory &GetSendBuffer() noexcept { return send_; }
+  /** @brief Get byte counts this rank sends to every peer */
+  inline const std::vector<size_t> &GetSendCounts() const noexcept { return send_counts_; }
+  /** @brief Get offsets of every outgoing shard in the send buffer */
+  inline const std::vector<size_t> &GetSendDispls() const noexcept { return send_displs_; }
+  /** @brief Get byte counts received from every peer */
+  inline const std::vector<size_t> &GetRecvCounts() const noexcept { return recv_counts_; }
+  /** @brief Get offsets of every incoming shard inside a receive slot */
+  inline const std::vector<size_t> &GetRecvDispls() const noexcept { return recv_displs_; }
+
+  /**
+   * @brief Get the receive slot filled by the last Run()
+   * @return Start of the slot; the shard from peer j starts at GetRecvDispls()[j]
+   */
+  inline char *GetRecvBuffer() const noexcept { return (char *)recv_.GetData() + ((step_ + 1) & 1) * recv_size_; }
+
+  /**
+   * @brief Exchange per-peer byte counts (collective over the group)
+   * @param send_counts Bytes this rank sends to each of the group ranks
+   * @throws std::invalid_argument if the shards do not fit the buffers
+   */
+  Coro<> Plan(const std::vector<size_t> &send_counts) {
+    if (!IsMember()) co_return;
+    const int n = group_;
+    const int r = comm_.GetRank();
+    if ((int)send_counts.size() != n) throw std::invalid_argument("alltoallv needs one count per group rank");
+    send_counts_ = send_counts;
+    send_displs_.assign(n, 0);
+    std::exclusive_scan(send_counts_.begin(), send_counts_.end(), send_displs_.begin(), (size_t)0);
+    if (send_displs_.back() + send_counts_.back() > send_.GetSize()) throw std::invalid_argument("alltoallv shards exceed send buffer");
+
+    auto matrix = (uint64_t *)counts_.GetData();
+    std::copy(send_counts_.begin(), send_counts_.end(), matrix + r * n);
+    auto row = r * n * sizeof(uint64_t);
+    for (int k = 1; k < n; ++k) {
+      auto peer = (r + k) % n;
+      auto &dst = matrices_[peer];
+      co_await Post(*comm_.GetConn(peer), counts_, row, n * sizeof(uint64_t), dst.addr + row, dst.key, Comm::Imm(kTagAlltoallv, 0, r));
+    }
+    for (int k = 1; k < n; ++k) {
+      auto src = (r + n - k) % n;
+      co_await comm_.GetConn(src)->Read(Comm::Imm(kTagAlltoallv, 0, src));
+    }
+    co_await Drain();
+
+    // a sender's shard starts after the shards of all lower ranks
+    recv_counts_.assign(n, 0);
+    recv_displs_.assign(n, 0);
+    remote_displs_.assign(n, 0);
+    for (int src = 0; src < n; ++src) recv_counts_[src] = matrix[src * n + r];
+    std::exclusive_scan(recv_counts_.begin(), recv_counts_.end(), recv_displs_.begin(), (size_t)0);
+    if (recv_displs_.back() + recv_counts_.back() > recv_size_) throw std::invalid_argument("alltoallv shards exceed receive slot");
+    for (int peer = 0; peer < n; ++peer) {
+      for (int src = 0; src < r; ++src) remote_displs_[peer] += matrix[src * n + peer];
+    }
+  }
+
+  /**
+   * @brief Run one exchange with the planned counts (collective over the group)
+   * @return Coroutine completing once every shard for this rank landed
+   */
+  Coro<> Run() {
+    if (!IsMember()) co_return;
+    const int n = group_;
+    const int r = comm_.GetRank();
+    auto parity = step_++ & 1;
+    auto slot = parity * recv_size_;
+    auto imm = Comm::Imm(kTagAlltoallv, 1 + parity, r);
+
+    std::memcpy((char *)recv_.GetData() + slot + recv_displs_[r], (char *)send_.GetData() + send_displs_[r], send_counts_[r]);
+    for (int k = 1; k < n; ++k) {
+      auto peer = (r + k) % n;
+      auto &dst = recvs_[peer];
+      auto addr = dst.addr + slot + remote_displs_[peer];
+      co_await Post(*comm_.GetConn(peer), send_, send_displs_[peer], send_counts_[peer], addr, dst.key, imm);
+    }
+    for (int k = 1; k < n; ++k) {
+      auto src = (r + n - k) % n;
+      co_await comm_.GetConn(src)->Read(Comm::Imm(kTagAlltoallv, 1 + parity, src));
+    }
+    co_await Drain();
+  }
+
+ private:
+  Coro<> Post(Conn &conn, const Memory &mem, size_t offset, size_t sz, uint64_t addr, uint64_t key, uint32_t imm) {
+    while (writes_.size() >= kDepth) {
+      co_await writes_.front();
+      writes_.pop_front();
+    }
+    writes_.emplace_back(Future(conn.Write(mem, offset, sz, addr, key, imm)));
+  }
+
+  Coro<> Drain() {
+    for (auto &w : writes_) co_await w;
+    writes_.clear();
+  }
+
+ private:
+  Comm &comm_;
+  int group_;
+  Memory send_;
+  Memory recv_;
+  Memory counts_;
+  size_t recv_size_;
+  uint64_t step_ = 0;
+  std::vector<Region> recvs_;
+  std::vector<Region> matrices_;
+  std::vector<size_t> send_counts_;
+  std::vector<size_t> send_displs_;
+  std::vector<size_t> recv_counts_;
+  std::vector<size_t> recv_displs_;
+  std::vector<size_t> remote_displs_;  // where our shard starts inside each peer's slot
+  std::deque<Future<Coro<size_t>>> writes_;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief Dissemination barrier over zero-length writes with immediate data
+ *
+ * In round k every rank signals rank + 2^k and waits for rank - 2^k, so all
+ * ranks are released after ceil(log2(N)) rounds. Signals carry
+ * Comm::Imm(kTagBarrier, round, epoch); a rank cannot get a full barrier
+ * ahead of a peer, so a 16-bit epoch is enough to keep consecutive barriers
+ * apart. Unlike MPI_Barrier it suspends instead of blocking, so other
+ * coroutines keep running on the event loop while a rank waits.
+ */
+class Barrier : private NoCopy {
+ public:
+  /**
+   * @brief Expose the signal memory (collective)
+   * @param comm Connected group
+   */
+  Barrier(Comm &comm) : comm_{comm}, signal_{kAlign} { signals_ = comm_.Expose(signal_); }
+
+  /**
+   * @brief Wait until every rank entered the barrier
+   * @return Coroutine completing once all ranks arrived
+   */
+  Coro<> Run() {
+    const int n = comm_.GetSize();
+    const int r = comm_.GetRank();
+    auto epoch = epoch_++ & 0xffff;
+    uint32_t round = 0;
+    for (int k = 1; k < n; k <<= 1, ++round) {
+      auto to = (r + k) % n;
+      auto from = (r + n - k) % n;
+      auto imm = Comm::Imm(kTagBarrier, round, epoch);
+      auto &dst = signals_[to];
+      auto w = Future(comm_.GetConn(to)->Write(signal_, 0, 0, dst.addr, dst.key, imm));
+      co_await comm_.GetConn(from)->Read(imm);
+      co_await w;
+    }
+  }
+
+ private:
+  Comm &comm_;
+  Memory signal_;
+  uint64_t epoch_ = 0;
+  std::vector<Region> signals_;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief Pipelined broadcast over a chain or a binary tree
+ *
+ * Ranks are renumbered relative to the root (v = rank - root mod N). In a
+ * chain v forwards to v + 1; in a tree v forwards to 2v + 1 and 2v + 2. The
+ * root cuts the buffer into chunks and writes them to its children with
+ * Comm::Imm(kTagBroadcast, 0, chunk). Every other rank waits for chunk k from
+ * its parent and forwards it right away, while chunk k + 1 is still arriving,
+ * so a chain streams at link speed once the pipeline is full and only adds
+ * one chunk of latency per hop.
+ *
+ * When a rank finished forwarding and heard from all of its children, it sends
+ * a zero-length write with Comm::Imm(kTagBroadcast, 1, v) to its parent. Run()
+ * on the root therefore returns once every rank holds the data, and no rank
+ * can start the next broadcast while a child still forwards the previous one.
+ */
+class Broadcast : private NoCopy {
+ public:
+  enum Topology { kChain, kTree };
+
+  /** @brief Default chunk size in bytes */
+  inline constexpr static size_t kChunkSize = 1 << 20;
+  /** @brief Writes kept in flight per rank */
+  inline constexpr static size_t kDepth = 16;
+
+  /**
+   * @brief Allocate and expose the broadcast buffer (collective)
+   * @param comm Connected group
+   * @param size Largest broadcast in bytes
+   * @param chunk Chunk size in bytes
+   */
+  Broadcast(Comm &comm, size_t size, size_t chunk = kChunkSize) : comm_{comm}, buffer_{size}, chunk_{chunk} {
+    ASSERT(chunk > 0);
+    buffers_ = comm_.Expose(buffer_);
+  }
+
+  /** @brief Get the buffer; the root's content is copied into every rank's */
+  inline Memory &GetBuffer() noexcept { return buffer_; }
+
+  /**
+   * @brief Broadcast the first size bytes of the root's buffer
+   * @param size Number of bytes
+   * @param root Source rank
+   * @param topo Forwarding topology
+   * @return Coroutine completing once this rank's subtree holds the data
+   * @throws std::invalid_argument if size does not fit or needs too many chunks
+   */
+  Coro<> Run(size_t size, int root, Topology topo) {
+    if (size > buffer_.GetSize()) throw std::invalid_argument("broadcast size exceeds buffer");
+    auto chunks = (size + chunk_ - 1) / chunk_;
+    if (chunks >= (1 << 16)) throw std::invalid_argument("broadcast needs a larger chunk size");
+    const int n = comm_.GetSize();
+    if (n == 1 or size == 0) co_return;
+
+    const int v = (comm_.GetRank() - root + n) % n;
+    auto rank = [&](int x) { return (x + root) % n; };
+    std::vector<int> children;
+    int parent = -1;
+    if (topo == kChain) {
+      if (v > 0) parent = rank(v - 1);
+      if (v + 1 < n) children.push_back(rank(v + 1));
+    } else {
+      if (v > 0) parent = rank((v - 1) / 2);
+      for (auto c : {2 * v + 1, 2 * v + 2}) {
+        if (c < n) children.push_back(rank(c));
+      }
+    }
+
+    for (size_t c = 0; c < chunks; ++c) {
+      auto off = c * chunk_;
+      auto len = std::min(chunk_, size - off);
+      auto imm = Comm::Imm(kTagBroadcast, 0, c);
+      if (parent >= 0) co_await comm_.GetConn(parent)->Read(imm);
+      for (auto child : children) co_await Post(*comm_.GetConn(child), off, len, buffers_[child], imm);
+    }
+    co_await Drain();
+
+    // immediates are matched per event loop, so tag acks with the child's position
+    for (auto child : children) co_await comm_.GetConn(child)->Read(Comm::Imm(kTagBroadcast, 1, (child - root + n) % n));
+    if (parent >= 0) co_await comm_.GetConn(parent)->Write(buffer_, 0, 0, buffers_[parent].addr, buffers_[parent].key, Comm::Imm(kTagBroadcast, 1, v));
+  }
+
+ private:
+  /**
+   * @brief Write bytes of the buffer to the same offset of a remote region
+   * @param conn Connection to the child
+   * @param off First byte
+   * @param len Number of bytes
+   * @param region Child's buffer
+   * @param imm Immediate data announcing the chunk
+   */
+  Coro<> Post(Conn &conn, size_t off, size_t len, const Region &region, uint32_t imm) {
+    while (writes_.size() >= kDepth) {
+      co_await writes_.front();
+      writes_.pop_front();
+    }
+    writes_.emplace_back(Future(conn.Write(buffer_, off, len, region.addr + off, region.key, imm)));
+  }
+
+  /** @brief Wait for every outstanding write */
+  Coro<> Drain() {
+    for (auto &w : writes_) co_await w;
+    writes_.clear();
+  }
+
+ private:
+  Comm &comm_;
+  Memory buffer_;
+  size_t chunk_;
+  std::vector<Region> buffers_;
+  std::deque<Future<Coro<size_t>>> writes_;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief One-way record stream through a ring of slots in the consumer's memory
+ *
+ * The consumer registers slots * slot_size bytes; the producer keeps a staging
+ * ring of the same layout. Push() copies a record (8-byte length + payload)
+ * into staging slot tail % slots and writes it to the same consumer slot. The
+ * write carries Comm::Imm(kTagChannel, 2 * id, tail), which both wakes Pop()
+ * and advances the consumer's view of the tail: on an unordered RDM endpoint
+ * a separate tail word could land before the record it publishes.
+ *
+ * The consumer hands out a record until the next Pop() and then frees its
+ * slot. Every half ring it advances the producer's head with a zero-length
+ * write carrying Comm::Imm(kTagChannel, 2 * id + 1, update); the producer
+ * consumes these opportunistically in Push() with Conn::Poll and only waits
+ * for one when the ring is full, so it can never overrun unread records.
+ */
+class Channel : private NoCopy {
+ public:
+  /** @brief Bytes in front of every record */
+  inline constexpr static size_t kHeader = sizeof(uint64_t);
+  /** @brief Writes kept in flight */
+  inline constexpr static size_t kDepth = 16;
+  /** @brief Largest channel id */
+  inline constexpr static uint32_t kMaxId = (1 << 11) - 1;
+
+  /**
+   * @brief Allocate and expose the ring (collective over the whole Comm)
+   * @param comm Connected group
+   * @param producer Rank calling Push()
+   * @param consumer Rank calling Pop()
+   * @param id Channel id, unique among channels ending on the same ranks
+   * @param slots Number of slots (2..32768)
+   * @param slot_size Slot size in bytes, including the record header
+   */
+  Channel(Comm &comm, int producer, int consumer, uint32_t id, size_t slots, size_t slot_size)
+      : comm_{comm},
+        producer_{producer},
+        consumer_{consumer},
+        id_{id},
+        slots_{slots},
+        slot_size_{slot_size},
+        half_{slots / 2},
+        ring_{IsEndpoint(comm, producer, consumer) ? slots * slot_size : kAlign} {
+    ASSERT(producer != consumer and id <= kMaxId);
+    ASSERT(slots >= 2 and slots <= (1 << 15) and slot_size > kHeader);
+    rings_ = comm_.Expose(ring_);
+  }
+
+  /** @brief Largest payload of a record */
+  inline size_t GetMaxRecord() const noexcept { return slot_size_ - kHeader; }
+  /** @brief Records pushed (producer) or popped (consumer) so far */
+  inline uint64_t GetTail() const noexcept { return tail_; }
+
+  /**
+   * @brief Append a record (producer only)
+   * @param data Payload
+   * @param len Payload size, at most GetMaxRecord()
+   * @return Coroutine completing once the record is posted
+   * @throws std::invalid_argument if the record does not fit a slot
+   */
+  Coro<> Push(const void *data, size_t len) {
+    ASSERT(comm_.GetRank() == producer_);
+    if (len > GetMaxRecord()) throw std::invalid_argument("record exceeds channel slot");
+    auto &conn = *comm_.GetConn(consumer_);
+    while (conn.Poll(Update(updates_))) head_ = ++updates_ * half_;
+    while (tail_ - head_ >= slots_) {
+      co_await conn.Read(Update(updates_));
+      head_ = ++updates_ * half_;
+    }
+
+    // fewer than slots writes stay queued, so the last write from this staging slot completed
+    while (writes_.size() >= std::min(kDepth, slots_)) {
+      co_await writes_.front();
+      writes_.pop_front();
+    }
+    auto offset = (tail_ % slots_) * slot_size_;
+    auto slot = (char *)ring_.GetData() + offset;
+    uint64_t size = len;
+    std::memcpy(slot, &size, kHeader);
+    std::memcpy(slot + kHeader, data, len);
+    auto &dst = rings_[consumer_];
+    writes_.emplace_back(Future(conn.Write(ring_, offset, kHeader + len, dst.addr + offset, dst.key, Record(tail_))));
+    ++tail_;
+  }
+
+  /** @brief Wait for every outstanding record or head update write */
+  Coro<> Flush() {
+    for (auto &w : writes_) co_await w;
+    writes_.clear();
+  }
+
+  /**
+   * @brief Take the next record (consumer only)
+   *
+   * The previous record is released, so its view must not be used afterwards.
+   *
+   * @return View of the payload inside the ring
+   */
+  Coro<std::span<char>> Pop() {
+    ASSERT(comm_.GetRank() == consumer_);
+    auto &conn = *comm_.GetConn(producer_);
+    if (head_ < tail_) co_await Release(conn);
+    co_await conn.Read(Record(tail_));
+    auto slot = (char *)ring_.GetData() + (tail_ % slots_) * slot_size_;
+    uint64_t size;
+    std::memcpy(&size, slot, kHeader);
+    ++tail_;
+    co_return std::span<char>{slot + kHeader, size};
+  }
+
+ private:
+  inline static bool IsEndpoint(Comm &comm, int producer, int consumer) noexcept {
+    return comm.GetRank() == producer or comm.GetRank() == consumer;
+  }
+
+  inline uint32_t Record(uint64_t seq) const noexcept { return Comm::Imm(kTagChannel, 2 * id_, seq & 0xffff); }
+  inline uint32_t Update(uint64_t seq) const noexcept { return Comm::Imm(kTagChannel, 2 * id_ + 1, seq & 0xffff); }
+
+  Coro<> Release(Conn &conn) {
+    if (++head_ % half_) co_return;
+    while (writes_.size() >= kDepth) {
+      co_await writes_.front();
+      writes_.pop_front();
+    }
+    auto &dst = rings_[producer_];
+    writes_.emplace_back(Future(conn.Write(ring_, 0, 0, dst.addr, dst.key, Update(updates_++))));
+  }
+
+ private:
+  Comm &comm_;
+  int producer_;
+  int consumer_;
+  uint32_t id_;
+  size_t slots_;
+  size_t slot_size_;
+  size_t half_;
+  Memory ring_;
+  uint64_t head_ = 0;     // records the consumer released
+  uint64_t tail_ = 0;     // records pushed or popped
+  uint64_t updates_ = 0;  // head updates sent or consumed
+  std::vector<Region> rings_;
+  std::deque<Future<Coro<size_t>>> writes_;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief steady_clock aligned to rank 0
+ *
+ * Sync() runs a ping-pong between every rank and rank 0: the rank sends a
+ * zero-length ping tagged Comm::Imm(kTagClock, 0, rank), rank 0 answers by
+ * writing its current time tagged Comm::Imm(kTagClock, 1, rank). Assuming
+ * symmetric paths, rank 0's clock read t_0 happened at the midpoint of the
+ * round trip, so offset = t_0 - (t_send + t_recv) / 2. Out of several rounds the
+ * one with the shortest round trip is kept; half of it bounds the error.
+ *
+ * Rank 0 serves ranks one after another so that each ping-pong measures an
+ * idle path. Steps 0 and 1 of kTagClock are taken; other users of the tag
+ * must pick higher steps.
+ */
+class Clock : private NoCopy {
+ public:
+  /** @brief Ping-pong rounds per rank */
+  inline constexpr static size_t kRounds = 16;
+
+  /**
+   * @brief Expose the timestamp memory (collective)
+   * @param comm Connected group
+   */
+  Clock(Comm &comm) : comm_{comm}, stamp_{kAlign} { stamps_ = comm_.Expose(stamp_); }
+
+  /** @brief Get local steady_clock in nanoseconds */
+  inline static int64_t Local() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  /** @brief Get steady_clock of rank 0 in nanoseconds, as estimated by the last Sync() */
+  inline int64_t Now() const noexcept { return Local() + offset_; }
+  /** @brief Get nanoseconds added to the local clock */
+  inline int64_t GetOffset() const noexcept { return offset_; }
+  /** @brief Get half of the best round trip in nanoseconds, a bound on the offset error */
+  inline int64_t GetError() const noexcept { return error_; }
+
+  /**
+   * @brief Estimate the offset to rank 0 (collective)
+   * @param rounds Ping-pong rounds per rank
+   * @return Coroutine completing once this rank's offset is known
+   */
+  Coro<> Sync(size_t rounds = kRounds) {
+    const int n = comm_.GetSize();
+    const int r = comm_.GetRank();
+    if (r == 0) {
+      offset_ = error_ = 0;
+      for (int peer = 1; peer < n; ++peer) {
+        auto &conn = *comm_.GetConn(peer);
+        auto &dst = stamps_[peer];
+        for (size_t i = 0; i < rounds; ++i) {
+          co_await conn.Read(Comm::Imm(kTagClock, 0, peer));
+          Store(Local());
+          co_await conn.Write(stamp_, 0, sizeof(int64_t), dst.addr, dst.key, Comm::Imm(kTagClock, 1, peer));
+        }
+      }
+      co_return;
+    }
+
+    auto &conn = *comm_.GetConn(0);
+    auto &dst = stamps_[0];
+    auto best = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < rounds; ++i) {
+      auto t0 = Local();
+      auto w = Future(conn.Write(stamp_, 0, 0, dst.addr, dst.key, Comm::Imm(kTagClock, 0, r)));
+      co_await conn.Read(Comm::Imm(kTagClock, 1, r));
+      auto t1 = Local();
+      co_await w;
+      if (t1 - t0 >= best) continue;
+      best = t1 - t0;
+      offset_ = Load() - (t0 + (t1 - t0) / 2);
+    }
+    error_ = best / 2;
+  }
+
+ private:
+  inline void Store(int64_t t) noexcept { std::memcpy(stamp_.GetData(), &t, sizeof(t)); }
+
+  inline int64_t Load() const noexcept {
+    int64_t t;
+    std::memcpy(&t, stamp_.GetData(), sizeof(t));
+    return t;
+  }
+
+ private:
+  Comm &comm_;
+  Memory stamp_;
+  int64_t offset_ = 0;
+  int64_t error_ = 0;
+  std::vector<Region> stamps_;
+};
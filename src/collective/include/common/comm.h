@@ -0,0 +1,118 @@
+#pragma once
+#include <mpi.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/efa.h"
+#include "common/mpi.h"
+#include "common/net.h"
+#include "common/utils.h"
+
+/**
+ * @brief Remote memory as addressed through one connection
+ */
+struct Region {
+  uint64_t addr;
+  uint64_t size;
+  uint64_t key;
+};
+
+/** @brief Immediate data namespaces of the collectives sharing one event loop */
+enum CollTag : uint32_t {
+  kTagAllreduce = 1,
+  kTagAlltoallv = 2,
+  kTagBroadcast = 3,
+  kTagBarrier = 4,
+  kTagClock = 5,
+  kTagHeap = 6,
+  kTagChannel = 7,
+};
+
+/**
+ * @brief Fully connected group of all MPI ranks
+ *
+ * Every rank opens one Net and connects to every other rank, through shm on
+ * the same node and EFA otherwise. MPI is only used during setup to exchange
+ * endpoint addresses and memory keys; data moves over Conn.
+ */
+class Comm : private NoCopy {
+ public:
+  Comm() {
+    auto &mpi = MPI::Get();
+    auto &efa = EFA::Get();
+    rank_ = mpi.GetWorldRank();
+    size_ = mpi.GetWorldSize();
+    net_.Open(efa.GetEFAInfo(), efa.GetShmInfo());
+
+    std::string endpoints(size_ * kMaxAddrSize, 0);
+    std::memcpy(endpoints.data() + ENDPOINT_IDX(rank_), net_.GetAddr(), kMaxAddrSize);
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, endpoints.data(), kMaxAddrSize, MPI_BYTE, MPI_COMM_WORLD);
+    conns_.resize(size_, nullptr);
+    local_.resize(size_, true);
+    for (int peer = 0; peer < size_; ++peer) {
+      if (peer == rank_) continue;
+      auto remote = endpoints.data() + ENDPOINT_IDX(peer);
+      local_[peer] = net_.IsLocal(remote);
+      conns_[peer] = net_.Connect(remote);
+      ASSERT(!!conns_[peer]);
+    }
+  }
+
+  /**
+   * @brief Register memory and learn where every rank's copy lives
+   *
+   * Collective over all ranks; each rank must expose memory in the same order.
+   *
+   * @param mem Memory to register with every open domain
+   * @return Region of each rank's memory, keyed for our connection to that rank
+   */
+  std::vector<Region> Expose(Memory &mem) {
+    struct Published {
+      uint64_t addr;
+      uint64_t size;
+      uint64_t efa_key;
+      uint64_t shm_key;
+    };
+    net_.Bind(mem);
+    std::vector<Published> all(size_);
+    all[rank_] = {(uint64_t)mem.GetData(), mem.GetSize(), net_.GetKey(mem, false), net_.GetKey(mem, true)};
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, all.data(), sizeof(Published), MPI_BYTE, MPI_COMM_WORLD);
+    std::vector<Region> regions(size_);
+    for (int peer = 0; peer < size_; ++peer) {
+      auto &p = all[peer];
+      regions[peer] = {p.addr, p.size, local_[peer] ? p.shm_key : p.efa_key};
+    }
+    return regions;
+  }
+
+  /**
+   * @brief Build immediate data for a collective message
+   * @param tag Collective namespace
+   * @param step Algorithm step (< 4096)
+   * @param chunk Chunk index within the step (< 65536)
+   * @return Non-zero 32-bit immediate data
+   */
+  inline static uint32_t Imm(CollTag tag, uint32_t step, uint32_t chunk) {
+    ASSERT(step < (1 << 12) and chunk < (1 << 16));
+    return (tag << 28) | (step << 16) | chunk;
+  }
+
+  /** @brief Get this rank */
+  inline int GetRank() const noexcept { return rank_; }
+  /** @brief Get number of ranks */
+  inline int GetSize() const noexcept { return size_; }
+  /** @brief Get connection to a peer (nullptr for this rank) */
+  inline Conn *GetConn(int peer) noexcept { return conns_[peer]; }
+  /** @brief Check whether a peer is reached through shm */
+  inline bool IsLocal(int peer) const noexcept { return local_[peer]; }
+
+ private:
+  Net net_;
+  int rank_ = 0;
+  int size_ = 0;
+  std::vector<Conn *> conns_;
+  std::vector<bool> local_;
+};
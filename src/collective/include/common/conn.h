@@ -0,0 +1,696 @@
+#pragma once
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/coro.h"
+#include "common/event.h"
+#include "common/utils.h"
+
+/** @brief Kind of a flow-controlled message */
+enum MsgType : uint32_t { kMsgData, kMsgCredit, kMsgRTS, kMsgACK };
+
+/**
+ * @brief Header in front of every message when credit-based flow control is enabled
+ */
+struct MsgHeader {
+  uint32_t credits;  ///< Receive slots re-posted by the sender of this message since its last message
+  uint32_t type;     ///< MsgType of the message
+  uint64_t size;     ///< Payload bytes following the header
+};
+
+/**
+ * @brief Rendezvous request telling the receiver where to pull a large payload from
+ */
+struct RTS {
+  uint64_t addr;  ///< Source address of the payload
+  uint64_t size;  ///< Payload size in bytes
+  uint64_t key;   ///< Remote key of the source memory region
+  uint64_t id;    ///< Sequence number echoed back by the ACK
+};
+
+/** @brief Largest payload of an eager flow-controlled message */
+constexpr size_t kMaxEagerSize = kBufferSize - sizeof(MsgHeader);
+
+/**
+ * @brief RDMA connection with coroutine-based async I/O
+ *
+ * With a non-zero window the connection uses receiver-granted credits. Each
+ * side pre-posts window + 1 receive slots. A Send consumes one credit and waits
+ * when none are left. A slot returned by Recv is re-posted on the next Recv and
+ * its credit travels back in the header of the next outgoing message, or in a
+ * credit-only update once half of the window is pending. The extra slot absorbs
+ * these updates, so a sender never posts a message without a receive waiting
+ * for it and the provider does not fall into RNR retries.
+ *
+ * Flow-controlled sends above the eager threshold use a rendezvous protocol.
+ * The sender posts a small RTS carrying the source address and key, the
+ * receiver pulls the payload with an RMA read straight into its read buffer and
+ * answers with an ACK, after which the sender's Send completes.
+ */
+class Conn : private NoCopy {
+ public:
+  /**
+   * @brief Create connection with endpoint and buffers
+   * @param ep Fabric endpoint handle
+   * @param domain RDMA domain for buffer registration
+   * @param remote Remote endpoint address
+   * @param window Credits granted to the peer (0 disables flow control)
+   */
+  Conn(struct fid_ep *ep, struct fid_domain *domain, fi_addr_t remote, size_t window = 0)
+      : ep_{ep},
+        domain_{domain},
+        remote_{remote},
+        window_{window},
+        credits_{window},
+        recv_buffer_{HostBuffer(domain, kBufferSize * (window + 1))},
+        send_buffer_{HostBuffer(domain, kBufferSize * (window + 1))},
+        read_buffer_{HostBuffer(domain, kMemoryRegionSize)},
+        write_buffer_{HostBuffer(domain, kMemoryRegionSize)} {
+    if (window_) Init();
+  }
+
+  /**
+   * @brief Awaiter for asynchronous receive operations
+   * Suspends coroutine until RDMA receive completes
+   */
+  struct recv_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    size_t size{0};
+    recv_awaiter(Conn *c, size_t sz) : conn{c}, size{sz} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      struct iovec iov{0};
+      struct fi_msg msg{0};
+      auto &buffer = conn->recv_buffer_;
+      iov.iov_base = buffer.GetData();
+      iov.iov_len = size;
+      msg.msg_iov = &iov;
+      msg.desc = &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = FI_ADDR_UNSPEC;
+      msg.context = &context;
+      CHECK(fi_recvmsg(conn->ep_, &msg, 0));
+      return true;
+    }
+
+    std::pair<char *, size_t> await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_recv = (flags & FI_RECV);
+      if (!is_recv) throw std::runtime_error(fmt::format("Invalid cq recv flags."));
+      char *buf = (char *)conn->recv_buffer_.GetData();
+      auto len = entry.len;
+      return {buf, len};
+    }
+  };
+
+  /**
+   * @brief Awaiter for asynchronous send operations
+   * Suspends coroutine until RDMA send completes
+   */
+  struct send_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    size_t size{0};
+    size_t offset{0};
+    send_awaiter(Conn *c, size_t sz, size_t off = 0) : conn{c}, size{sz}, offset{off} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &buffer = conn->send_buffer_;
+      struct iovec iov{0};
+      struct fi_msg msg{0};
+      iov.iov_base = (char *)buffer.GetData() + offset;
+      iov.iov_len = size;
+      msg.msg_iov = &iov;
+      msg.desc = &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = conn->remote_;
+      msg.context = &context;
+      CHECK(fi_sendmsg(conn->ep_, &msg, 0));
+      return true;
+    }
+
+    size_t await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_send = (flags & FI_SEND);
+      if (!is_send) throw std::runtime_error(fmt::format("Invalid cq send flags."));
+      return entry.len;
+    }
+  };
+
+  /**
+   * @brief Coroutine awaiter for asynchronous operations
+   */
+  struct write_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    const char *data{0};
+    size_t size{0};
+    uint64_t addr{0};
+    uint64_t key{0};
+    uint64_t imm_data{0};
+    void *desc{0};
+    write_awaiter(Conn *c, const char *d, size_t sz, uint64_t a, uint64_t k, uint64_t i, void *m = nullptr)
+        : conn{c}, data{d}, size{sz}, addr{a}, key{k}, imm_data{i}, desc{m} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &buffer = conn->write_buffer_;
+      struct iovec iov;
+      struct fi_rma_iov rma_iov;
+      struct fi_msg_rma msg;
+      iov.iov_base = (void *)data;
+      iov.iov_len = size;
+      rma_iov.addr = addr;
+      rma_iov.len = size;
+      rma_iov.key = key;
+      msg.msg_iov = &iov;
+      msg.desc = desc ? &desc : &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = conn->remote_;
+      msg.rma_iov = &rma_iov;
+      msg.rma_iov_count = 1;
+      msg.context = &context;
+      msg.data = imm_data;
+      uint64_t flags = 0;
+      if (imm_data) flags |= FI_REMOTE_CQ_DATA;
+      CHECK(fi_writemsg(conn->ep_, &msg, flags));
+      return true;
+    }
+
+    size_t await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_write = (flags & FI_WRITE);
+      if (!is_write) throw std::runtime_error(fmt::format("Invalid cq write flags."));
+      return entry.len;
+    }
+  };
+
+  /**
+   * @brief Awaiter for RMA reads pulling remote memory into local memory
+   */
+  struct rma_read_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    char *data{0};
+    size_t size{0};
+    uint64_t addr{0};
+    uint64_t key{0};
+    void *desc{0};
+    rma_read_awaiter(Conn *c, char *d, size_t sz, uint64_t a, uint64_t k, void *m = nullptr)
+        : conn{c}, data{d}, size{sz}, addr{a}, key{k}, desc{m} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &buffer = conn->read_buffer_;
+      struct iovec iov;
+      struct fi_rma_iov rma_iov;
+      struct fi_msg_rma msg{};
+      iov.iov_base = data;
+      iov.iov_len = size;
+      rma_iov.addr = addr;
+      rma_iov.len = size;
+      rma_iov.key = key;
+      msg.msg_iov = &iov;
+      msg.desc = desc ? &desc : &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = conn->remote_;
+      msg.rma_iov = &rma_iov;
+      msg.rma_iov_count = 1;
+      msg.context = &context;
+      CHECK(fi_readmsg(conn->ep_, &msg, 0));
+      return true;
+    }
+
+    size_t await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_read = (flags & FI_READ);
+      if (!is_read) throw std::runtime_error(fmt::format("Invalid cq read flags."));
+      return size;
+    }
+  };
+
+  /**
+   * @brief Coroutine awaiter for asynchronous operations
+   */
+  struct remote_write_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    uint64_t imm_data{0};
+    remote_write_awaiter(Conn *c, uint64_t i) : conn{c}, imm_data{i} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &io = IO::Get();
+      if (io.Claim(imm_data, &context)) return false;
+      io.Register(imm_data, &context);
+      return true;
+    }
+
+    char *await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_remote_write = (flags & FI_REMOTE_WRITE);
+      if (!is_remote_write) throw std::runtime_error(fmt::format("Invalid remote write flags."));
+      IO::Get().UnRegister(imm_data);
+      return (char *)conn->read_buffer_.GetData();
+    }
+  };
+
+  /**
+   * @brief Awaiter parking a coroutine until the connection state changes
+   * Woken by Wake() when credits, send slots or messages become available
+   */
+  struct wait_awaiter {
+    std::deque<Handle *> &waiters;
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      waiters.emplace_back(&coroutine.promise());
+    }
+
+    constexpr void await_resume() const noexcept {}
+  };
+
+  /**
+   * @brief Pre-posted receive slot, run by the event loop when a message lands
+   */
+  struct recv_slot : Handle {
+    Conn *conn{0};
+    Context context{0};
+    char *data{0};
+    recv_slot(Conn *c, char *d) : conn{c}, data{d} { context.handle = this; }
+    void run() override { conn->OnRecv(*this); }
+  };
+
+  /**
+   * @brief Send context of credit-only updates
+   */
+  struct credit_slot : Handle {
+    Conn *conn{0};
+    Context context{0};
+    explicit credit_slot(Conn *c) : conn{c} { context.handle = this; }
+    void run() override { conn->OnCreditSent(); }
+  };
+
+  /**
+   * @brief Asynchronously receive data
+   * @param sz Maximum bytes to receive (default: kBufferSize)
+   * @return Coroutine yielding {buffer_ptr, actual_size}
+   * @throws std::invalid_argument if sz <= 0
+   *
+   * With flow control the returned buffer stays valid until the next Recv,
+   * which hands the slot back to the peer.
+   */
+  Coro<std::pair<char *, size_t>> Recv(size_t sz = kBufferSize) { return Recv(oneway, sz); }
+
+  /**
+   * @brief Asynchronously send data
+   * @param data Data buffer to send
+   * @param sz Number of bytes to send
+   * @return Coroutine yielding bytes sent
+   * @throws std::invalid_argument if data is NULL or sz <= 0
+   *
+   * With flow control the call waits for a credit before posting, so data
+   * must stay valid until the returned coroutine completes. Payloads above the
+   * eager threshold are pulled by the peer, so the coroutine completes once the
+   * peer acknowledged the read.
+   */
+  Coro<size_t> Send(const char *data, size_t sz) { return Send(oneway, data, sz); }
+
+  Coro<size_t> Write(const char *data, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
+    return Write(oneway, data, sz, addr, key, imm_data);
+  }
+
+  /**
+   * @brief Asynchronously write from registered Memory to a remote address
+   * @param mem Source memory, bound to this connection's domain
+   * @param offset Byte offset of the source inside mem
+   * @param sz Number of bytes to write
+   * @param addr Remote address
+   * @param key Remote memory key
+   * @param imm_data Immediate data raised at the peer (0 for none)
+   * @return Coroutine yielding bytes written
+   *
+   * sz may be 0 when imm_data is set, which only signals the peer.
+   */
+  Coro<size_t> Write(const Memory &mem, size_t offset, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
+    return Write(oneway, mem, offset, sz, addr, key, imm_data);
+  }
+
+  /**
+   * @brief Asynchronously read remote memory into registered Memory
+   * @param mem Destination memory, bound to this connection's domain
+   * @param offset Byte offset of the destination inside mem
+   * @param sz Number of bytes to read
+   * @param addr Remote address
+   * @param key Remote memory key
+   * @return Coroutine yielding bytes read once they landed in mem
+   */
+  Coro<size_t> Read(Memory &mem, size_t offset, size_t sz, uint64_t addr, uint64_t key) { return Read(oneway, mem, offset, sz, addr, key); }
+
+  /**
+   * @brief Wait for a remote write carrying imm_data
+   *
+   * A write that landed before the call is buffered by the selector and
+   * returned at once, so peers may run ahead of the reader.
+   */
+  Coro<char *> Read(uint64_t imm_data) { return Read(oneway, imm_data); }
+
+  /**
+   * @brief Consume a remote write carrying imm_data if it already arrived
+   * @return true if such a write was buffered and is now consumed
+   */
+  bool Poll(uint64_t imm_data) {
+    Context context{0};
+    if (!IO::Get().Claim(imm_data, &context)) return false;
+    if (!(context.entry.flags & FI_REMOTE_WRITE)) throw std::runtime_error(fmt::format("Invalid remote write flags."));
+    return true;
+  }
+
+  /** @brief Get send buffer reference */
+  inline HostBuffer &GetSendBuffer() noexcept { return send_buffer_; }
+  /** @brief Get receive buffer reference */
+  inline HostBuffer &GetRecvBuffer() noexcept { return recv_buffer_; }
+  /** @brief Get RMA write buffer reference */
+  inline HostBuffer &GetWriteBuffer() noexcept { return write_buffer_; }
+  /** @brief Get RMA read buffer reference */
+  inline HostBuffer &GetReadBuffer() noexcept { return read_buffer_; }
+  /** @brief Get the domain the connection's memory is registered with */
+  inline struct fid_domain *GetDomain() const noexcept { return domain_; }
+  /** @brief Get credit window (0 if flow control is disabled) */
+  inline size_t GetWindow() const noexcept { return window_; }
+  /** @brief Get credits currently available to Send */
+  inline size_t GetCredits() const noexcept { return credits_; }
+
+  /**
+   * @brief Set the largest payload sent eagerly; larger sends use rendezvous
+   * @param threshold Eager limit in bytes (clamped to kMaxEagerSize)
+   */
+  inline void SetEagerThreshold(size_t threshold) noexcept { eager_ = std::min(threshold, kMaxEagerSize); }
+  /** @brief Get the eager threshold in bytes */
+  inline size_t GetEagerThreshold() const noexcept { return eager_; }
+
+ private:
+  /**
+   * @brief Asynchronously receive data
+   * @param sz Maximum bytes to receive (default: kBufferSize)
+   * @return Coroutine yielding {buffer_ptr, actual_size}
+   * @throws std::invalid_argument if sz <= 0
+   */
+  Coro<std::pair<char *, size_t>> Recv(Oneway, size_t sz = kBufferSize) {
+    if (sz <= 0) throw std::invalid_argument("Recv buffer size should be greater than 0");
+    if (!window_) co_return co_await recv_awaiter(this, sz);
+
+    Release();
+    while (ready_.empty()) co_await wait_awaiter{waiters_};
+    auto slot = ready_.front();
+    ready_.pop_front();
+    held_ = slot;
+    auto header = (MsgHeader *)slot->data;
+    auto payload = slot->data + sizeof(MsgHeader);
+    if (header->type != kMsgRTS) co_return std::pair<char *, size_t>{payload, header->size};
+
+    auto rts = *(RTS *)payload;
+    if (rts.size > read_buffer_.GetSize()) throw std::runtime_error(fmt::format("rendezvous size {} exceeds read buffer", rts.size));
+    auto dst = (char *)read_buffer_.GetData();
+    co_await rma_read_awaiter(this, dst, rts.size, rts.addr, rts.key);
+    co_await SendMsg(kMsgACK, (const char *)&rts.id, sizeof(rts.id));
+    co_return std::pair<char *, size_t>{dst, rts.size};
+  }
+
+  /**
+   * @brief Asynchronously send data
+   * @param data Data buffer to send
+   * @param sz Number of bytes to send
+   * @return Coroutine yielding bytes sent
+   * @throws std::invalid_argument if data is NULL or sz <= 0
+   */
+  Coro<size_t> Send(Oneway, const char *data, size_t sz) {
+    if (!data) throw std::invalid_argument("Send data is NULL");
+    if (sz <= 0) throw std::invalid_argument("Send buffer size should be greater than 0");
+    if (!window_) {
+      if (sz > kBufferSize) throw std::invalid_argument("Send size exceeds kBufferSize without flow control");
+      auto buffer = send_buffer_.GetData();
+      std::memcpy(buffer, data, sz);
+      co_return co_await send_awaiter(this, sz);
+    }
+
+    if (sz > eager_) co_return co_await Rendezvous(data, sz);
+    co_return co_await SendMsg(kMsgData, data, sz);
+  }
+
+  /**
+   * @brief Send a framed message once a credit and a send slot are available
+   * @param type Message type written into the header
+   * @param data Payload
+   * @param sz Payload size (at most kMaxEagerSize)
+   * @return Coroutine yielding payload bytes sent
+   */
+  Coro<size_t> SendMsg(MsgType type, const char *data, size_t sz) {
+    while (!credits_ or free_sends_.empty()) co_await wait_awaiter{waiters_};
+    --credits_;
+    auto index = free_sends_.back();
+    free_sends_.pop_back();
+    auto buffer = (char *)send_buffer_.GetData() + index * kBufferSize;
+    auto header = (MsgHeader *)buffer;
+    header->credits = std::exchange(pending_, 0);
+    header->type = type;
+    header->size = sz;
+    std::memcpy(buffer + sizeof(MsgHeader), data, sz);
+    auto len = co_await send_awaiter(this, sizeof(MsgHeader) + sz, index * kBufferSize);
+    free_sends_.emplace_back(index);
+    Wake();
+    co_return len - sizeof(MsgHeader);
+  }
+
+  /**
+   * @brief Send a large payload by letting the peer pull it
+   * @param data Payload, registered on the fly unless it lies in the write buffer
+   * @param sz Payload size
+   * @return Coroutine yielding bytes sent once the peer acknowledged the read
+   */
+  Coro<size_t> Rendezvous(const char *data, size_t sz) {
+    struct fid_mr *mr = nullptr;
+    auto base = (const char *)write_buffer_.GetData();
+    auto inside = data >= base and data + sz <= base + write_buffer_.GetSize();
+    if (!inside) mr = Register(domain_, data, sz);
+    RTS rts{(uint64_t)data, sz, inside ? write_buffer_.GetMR()->key : mr->key, ++seq_};
+    co_await SendMsg(kMsgRTS, (const char *)&rts, sizeof(rts));
+    while (!acked_.erase(rts.id)) co_await wait_awaiter{waiters_};
+    if (mr) fi_close((fid_t)mr);
+    co_return sz;
+  }
+
+  /**
+   * @brief Register caller memory for remote reads
+   * @param domain RDMA domain for registration
+   * @param data Buffer data pointer
+   * @param size Buffer size in bytes
+   * @return Memory region handle
+   * @throws std::runtime_error on registration failure
+   */
+  inline static struct fid_mr *Register(struct fid_domain *domain, const char *data, size_t size) {
+    struct fid_mr *mr;
+    struct fi_mr_attr mr_attr = {};
+    struct iovec iov = {.iov_base = (void *)data, .iov_len = size};
+    mr_attr.mr_iov = &iov;
+    mr_attr.iov_count = 1;
+    mr_attr.access = FI_REMOTE_READ;
+    CHECK(fi_mr_regattr(domain, &mr_attr, 0, &mr));
+    return mr;
+  }
+
+  Coro<size_t> Write(Oneway, const char *data, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
+    if (!data) throw std::invalid_argument("Write data is NULL");
+    if (sz <= 0) throw std::invalid_argument("Write buffer size should be greater than 0");
+    co_return co_await write_awaiter(this, data, sz, addr, key, imm_data);
+  }
+
+  Coro<size_t> Write(Oneway, const Memory &mem, size_t offset, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data) {
+    auto mr = mem.GetMR(domain_);
+    if (!mr) throw std::invalid_argument("Write memory is not bound to the connection's domain");
+    // a zero-length write still raises imm_data and serves as a pure signal
+    if ((sz == 0 and !imm_data) or offset + sz > mem.GetSize()) throw std::invalid_argument("Write range exceeds memory");
+    auto data = (const char *)mem.GetData() + offset;
+    co_return co_await write_awaiter(this, data, sz, addr, key, imm_data, fi_mr_desc(mr));
+  }
+
+  Coro<size_t> Read(Oneway, Memory &mem, size_t offset, size_t sz, uint64_t addr, uint64_t key) {
+    auto mr = mem.GetMR(domain_);
+    if (!mr) throw std::invalid_argument("Read memory is not bound to the connection's domain");
+    if (sz == 0 or offset + sz > mem.GetSize()) throw std::invalid_argument("Read range exceeds memory");
+    co_return co_await rma_read_awaiter(this, (char *)mem.GetData() + offset, sz, addr, key, fi_mr_desc(mr));
+  }
+
+  Coro<char *> Read(Oneway, uint64_t imm_data) {
+    if (imm_data == 0) throw std::invalid_argument("imm_data should be greater than 0");
+    co_return co_await remote_write_awaiter(this, imm_data);
+  }
+
+  /**
+   * @brief Pre-post every receive slot and mark every data send slot free
+   */
+  inline void Init() {
+    auto base = (char *)recv_buffer_.GetData();
+    for (size_t i = 0; i <= window_; ++i) {
+      recv_slots_.emplace_back(std::make_unique<recv_slot>(this, base + i * kBufferSize));
+      PostRecv(*recv_slots_.back());
+    }
+    // the last send slot is reserved for credit-only updates
+    for (size_t i = 0; i < window_; ++i) free_sends_.emplace_back(i);
+  }
+
+  /**
+   * @brief Post a directed receive on a slot
+   * @param slot Receive slot to post
+   */
+  inline void PostRecv(recv_slot &slot) {
+    struct iovec iov{0};
+    struct fi_msg msg{0};
+    iov.iov_base = slot.data;
+    iov.iov_len = kBufferSize;
+    msg.msg_iov = &iov;
+    msg.desc = &recv_buffer_.GetMR()->mem_desc;
+    msg.iov_count = 1;
+    msg.addr = remote_;
+    msg.context = &slot.context;
+    CHECK(fi_recvmsg(ep_, &msg, 0));
+  }
+
+  /**
+   * @brief Handle a completed receive slot
+   * @param slot Slot whose receive completed
+   */
+  inline void OnRecv(recv_slot &slot) {
+    auto &entry = slot.context.entry;
+    if (!(entry.flags & FI_RECV)) throw std::runtime_error(fmt::format("Invalid cq recv flags."));
+    auto header = (MsgHeader *)slot.data;
+    credits_ += header->credits;
+    switch (header->type) {
+      case kMsgCredit:
+        PostRecv(slot);
+        break;
+      case kMsgACK:
+        // acknowledgements never reach Recv, so their slot is returned at once
+        acked_.emplace(*(uint64_t *)(slot.data + sizeof(MsgHeader)));
+        PostRecv(slot);
+        ++pending_;
+        Flush();
+        break;
+      default:
+        ready_.emplace_back(&slot);
+        break;
+    }
+    Wake();
+  }
+
+  /**
+   * @brief Re-post the slot handed out by the previous Recv and return its credit
+   */
+  inline void Release() {
+    if (!held_) return;
+    PostRecv(*std::exchange(held_, nullptr));
+    ++pending_;
+    Flush();
+  }
+
+  /**
+   * @brief Send a credit-only update once half of the window is pending
+   *
+   * Waiting for half of the window keeps updates rare. It cannot starve the
+   * peer: while fewer credits are pending, the peer still holds more than half
+   * of the window or has messages in flight that will trigger another Flush.
+   */
+  inline void Flush() {
+    if (updating_ or pending_ < std::max<size_t>(1, window_ / 2)) return;
+    updating_ = true;
+    auto offset = window_ * kBufferSize;
+    auto header = (MsgHeader *)((char *)send_buffer_.GetData() + offset);
+    header->credits = std::exchange(pending_, 0);
+    header->type = kMsgCredit;
+    header->size = 0;
+    struct iovec iov{0};
+    struct fi_msg msg{0};
+    iov.iov_base = header;
+    iov.iov_len = sizeof(MsgHeader);
+    msg.msg_iov = &iov;
+    msg.desc = &send_buffer_.GetMR()->mem_desc;
+    msg.iov_count = 1;
+    msg.addr = remote_;
+    msg.context = &credit_slot_.context;
+    CHECK(fi_sendmsg(ep_, &msg, 0));
+  }
+
+  /**
+   * @brief Handle completion of a credit-only update
+   */
+  inline void OnCreditSent() {
+    updating_ = false;
+    Flush();
+  }
+
+  /**
+   * @brief Resume every coroutine parked in wait_awaiter
+   */
+  inline void Wake() {
+    auto &io = IO::Get();
+    while (!waiters_.empty()) {
+      io.Call(*waiters_.front());
+      waiters_.pop_front();
+    }
+  }
+
+ private:
+  struct fid_ep *ep_ = nullptr;
+  struct fid_domain *domain_ = nullptr;
+  fi_addr_t remote_;
+  size_t window_ = 0;
+  size_t eager_ = kMaxEagerSize;  // largest payload sent eagerly
+  uint64_t seq_ = 0;              // last rendezvous id
+  std::unordered_set<uint64_t> acked_;
+  size_t credits_ = 0;           // credits granted by the peer
+  size_t pending_ = 0;           // credits not yet returned to the peer
+  bool updating_ = false;        // a credit-only update is in flight
+  recv_slot *held_ = nullptr;    // slot handed out by the last Recv
+  credit_slot credit_slot_{this};
+  std::vector<std::unique_ptr<recv_slot>> recv_slots_;
+  std::deque<recv_slot *> ready_;
+  std::vector<size_t> free_sends_;
+  std::deque<Handle *> waiters_;
+  HostBuffer recv_buffer_;
+  HostBuffer send_buffer_;
+  HostBuffer read_buffer_;
+  HostBuffer write_buffer_;
+};
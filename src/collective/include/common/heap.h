@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "common/buffer.h"
+#include "common/comm.h"
+#include "common/coro.h"
+#include "common/future.h"
+
+/**
+ * @brief Symmetric heap with SHMEM-style one-sided operations
+ *
+ * Every rank registers an arena of the same size and the arena's address and
+ * keys are exchanged once, so a remote location is just (rank, offset) and
+ * every Put/Get translates it locally without any handshake. Alloc() is a bump
+ * allocator; as long as all ranks allocate in the same order an offset names
+ * the same object on every rank, like shmem_malloc.
+ *
+ * Put() posts a write and returns once it is in flight; Quiet() waits for every
+ * outstanding put, after which their sources may be reused. Completion of a put
+ * says nothing about when the target observes the data; use PutSignal(), whose
+ * immediate data is delivered only after its payload landed, and WaitSignal()
+ * on the target. Signals are matched by value on the target's event loop, so
+ * concurrent senders to the same target must use distinct values.
+ */
+class Heap : private NoCopy {
+ public:
+  /** @brief Puts kept in flight before Put() waits */
+  inline constexpr static size_t kDepth = 64;
+  /** @brief Largest signal value */
+  inline constexpr static uint32_t kMaxSignal = (1 << 28) - 1;
+
+  /**
+   * @brief Allocate and expose the arena (collective)
+   * @param comm Connected group
+   * @param size Arena size in bytes, identical on every rank
+   * @throws std::runtime_error if ranks passed different sizes
+   */
+  Heap(Comm &comm, size_t size) : comm_{comm}, arena_{size} {
+    regions_ = comm_.Expose(arena_);
+    for (auto &region : regions_) {
+      if (region.size != size) throw std::runtime_error("symmetric heap size differs between ranks");
+    }
+  }
+
+  /**
+   * @brief Reserve a symmetric object
+   * @param size Object size in bytes
+   * @param align Object alignment (power of two)
+   * @return Offset of the object, the same on every rank
+   * @throws std::runtime_error if the arena is exhausted
+   */
+  size_t Alloc(size_t size, size_t align = kAlign) {
+    auto offset = (top_ + align - 1) & ~(align - 1);
+    if (offset + size > arena_.GetSize()) throw std::runtime_error("symmetric heap exhausted");
+    top_ = offset + size;
+    return offset;
+  }
+
+  /** @brief Get the local address of a symmetric offset */
+  template <typename T = char>
+  inline T *Ptr(size_t offset) const noexcept {
+    return (T *)((char *)arena_.GetData() + offset);
+  }
+
+  /**
+   * @brief Copy len bytes from local src to offset on rank
+   * @param rank Target rank (this rank copies locally)
+   * @param offset Symmetric destination offset
+   * @param src Source inside this rank's heap
+   * @param len Number of bytes
+   * @return Coroutine completing once the write is posted
+   * @throws std::invalid_argument if src or the destination is outside the heap
+   */
+  Coro<> Put(int rank, size_t offset, const void *src, size_t len) { return Put(oneway, rank, offset, src, len, 0); }
+
+  /**
+   * @brief Put() that raises signal on the target once the data landed
+   * @param signal Value the target waits for in WaitSignal() (<= kMaxSignal)
+   * @throws std::invalid_argument if rank is this rank
+   */
+  Coro<> PutSignal(int rank, size_t offset, const void *src, size_t len, uint32_t signal) {
+    if (rank == comm_.GetRank()) throw std::invalid_argument("PutSignal needs a remote rank");
+    ASSERT(signal <= kMaxSignal);
+    return Put(oneway, rank, offset, src, len, Signal(signal));
+  }
+
+  /**
+   * @brief Wait for a PutSignal() from rank
+   * @param rank Sending rank
+   * @param signal Signal value
+   */
+  Coro<> WaitSignal(int rank, uint32_t signal) {
+    ASSERT(signal <= kMaxSignal);
+    co_await comm_.GetConn(rank)->Read(Signal(signal));
+  }
+
+  /**
+   * @brief Copy len bytes from offset on rank into local dst
+   * @param rank Source rank (this rank copies locally)
+   * @param offset Symmetric source offset
+   * @param dst Destination inside this rank's heap
+   * @param len Number of bytes
+   * @return Coroutine completing once the data is in dst
+   * @throws std::invalid_argument if dst or the source is outside the heap
+   */
+  Coro<> Get(int rank, size_t offset, void *dst, size_t len) {
+    auto local = Offset(dst, len);
+    Check(offset, len);
+    if (rank == comm_.GetRank()) {
+      std::memmove(dst, Ptr(offset), len);
+      co_return;
+    }
+    if (len == 0) co_return;
+    auto &region = regions_[rank];
+    co_await comm_.GetConn(rank)->Read(arena_, local, len, region.addr + offset, region.key);
+  }
+
+  /** @brief Wait until every outstanding put completed */
+  Coro<> Quiet() {
+    for (auto &w : puts_) co_await w;
+    puts_.clear();
+  }
+
+ private:
+  Coro<> Put(Oneway, int rank, size_t offset, const void *src, size_t len, uint32_t imm) {
+    auto local = Offset(src, len);
+    Check(offset, len);
+    if (rank == comm_.GetRank()) {
+      std::memmove(Ptr(offset), src, len);
+      co_return;
+    }
+    if (len == 0 and !imm) co_return;
+    while (puts_.size() >= kDepth) {
+      co_await puts_.front();
+      puts_.pop_front();
+    }
+    auto &region = regions_[rank];
+    puts_.emplace_back(Future(comm_.GetConn(rank)->Write(arena_, local, len, region.addr + offset, region.key, imm)));
+  }
+
+  inline static uint32_t Signal(uint32_t signal) noexcept { return Comm::Imm(kTagHeap, signal >> 16, signal & 0xffff); }
+
+  inline void Check(size_t offset, size_t len) const {
+    if (offset + len > arena_.GetSize()) throw std::invalid_argument("symmetric offset outside the heap");
+  }
+
+  inline size_t Offset(const void *p, size_t len) const {
+    auto base = (const char *)arena_.GetData();
+    auto c = (const char *)p;
+    if (c < base or c + len > base + arena_.GetSize()) throw std::invalid_argument("local buffer outside the heap");
+    return c - base;
+  }
+
+ private:
+  Comm &comm_;
+  Memory arena_;
+  size_t top_ = 0;
+  std::vector<Region> regions_;
+  std::deque<Future<Coro<size_t>>> puts_;
+};
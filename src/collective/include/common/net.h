@@ -0,0 +1,161 @@
+#pragma once
+#include <rdma/fabric.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "common/conn.h"
+#include "common/io.h"
+#include "common/utils.h"
+
+/**
+ * @brief Addresses of all endpoints owned by a Net, exchanged between peers
+ */
+struct NetAddr {
+  int32_t node;                ///< Node index of the owner
+  char efa[kAddrSize];         ///< EFA endpoint address (zero if no EFA device)
+  char shm[kMaxShmAddrSize];  ///< shm endpoint name (empty if shm is unavailable)
+};
+
+static_assert(sizeof(NetAddr) <= kMaxAddrSize);
+
+/**
+ * @brief Fabric objects of a single provider endpoint
+ */
+struct Endpoint {
+  struct fid_fabric *fabric = nullptr;
+  struct fid_domain *domain = nullptr;
+  struct fid_ep *ep = nullptr;
+  struct fid_cq *cq = nullptr;
+  struct fid_av *av = nullptr;
+};
+
+/**
+ * @brief Network abstraction for EFA fabric operations
+ *
+ * A Net opens an EFA endpoint for inter-node peers and, when the shm provider
+ * is available, a second shm endpoint for peers on the same node. Connect()
+ * picks the endpoint from the node index carried in the remote address, so
+ * callers see the same Conn interface for both paths.
+ */
+class Net {
+ public:
+  Net() = default;
+  ~Net();
+
+  /**
+   * @brief Initialize network with fabric info
+   * @param info EFA fabric information (nullptr to use shm only)
+   * @param shm shm fabric information (nullptr to route every peer through EFA)
+   * @throws std::runtime_error on fabric initialization failure
+   */
+  void Open(struct fi_info *info, struct fi_info *shm = nullptr);
+
+  /**
+   * @brief Establish connection to remote endpoint
+   * @param remote Remote address buffer returned by the peer's GetAddr()
+   * @param window Send/recv credits granted to the peer (0 disables flow control)
+   * @return Pointer to connection object
+   * @throws std::runtime_error on connection failure
+   */
+  Conn *Connect(const char *remote, size_t window = 0);
+
+  /**
+   * @brief Register memory with every open domain
+   * @param mem Memory to bind
+   * @throws std::runtime_error on registration failure
+   */
+  void Bind(Memory &mem) {
+    if (efa_.domain) mem.Bind(efa_.domain);
+    if (shm_.domain) mem.Bind(shm_.domain);
+  }
+
+  /**
+   * @brief Get the key peers use to address bound memory
+   * @param mem Memory passed to Bind()
+   * @param local true for the shm registration, false for EFA
+   * @return Memory key, or 0 if the path is not open
+   */
+  uint64_t GetKey(const Memory &mem, bool local) const noexcept {
+    auto mr = mem.GetMR(local ? shm_.domain : efa_.domain);
+    return mr ? mr->key : 0;
+  }
+
+  /**
+   * @brief Check whether a remote peer is reached through shared memory
+   * @param remote Remote address buffer returned by the peer's GetAddr()
+   * @return true if the peer lives on this node and shm is open
+   */
+  bool IsLocal(const char *remote) const noexcept {
+    auto addr = (const NetAddr *)remote;
+    return !!shm_.ep and addr->node == addr_.node;
+  }
+
+  /**
+   * @brief Get local endpoint address
+   * @return Local address buffer (kMaxAddrSize bytes)
+   */
+  const char *GetAddr() { return (const char *)&addr_; }
+
+  /**
+   * @brief Get completion queue handle
+   * @return Completion queue file descriptor
+   */
+  struct fid_cq *GetCQ() { return efa_.cq; }
+
+  /**
+   * @brief Convert binary address to hex string
+   * @param addr Binary address buffer
+   * @return Hex string representation
+   */
+  inline static std::string Addr2Str(const char *addr) {
+    std::string out;
+    for (size_t i = 0; i < kAddrSize; ++i) out += fmt::format("{:02x}", addr[i]);
+    return out;
+  }
+
+  /**
+   * @brief Convert hex string to binary address
+   * @param addr Hex string address
+   * @param bytes Output binary buffer
+   */
+  inline static void Str2Addr(const std::string &addr, char *bytes) {
+    for (size_t i = 0; i < kAddrSize; ++i) sscanf(addr.c_str() + 2 * i, "%02hhx", &bytes[i]);
+  }
+
+ private:
+  static void Open(struct fi_info *info, Endpoint &e, char *addr, size_t len);
+  static void Close(Endpoint &e);
+
+  inline void Register() {
+    auto &io = IO::Get();
+    if (efa_.cq) io.Register(efa_.cq);
+    if (shm_.cq) io.Register(shm_.cq);
+  }
+
+  inline void UnRegister() {
+    auto &io = IO::Get();
+    if (efa_.cq) io.UnRegister(efa_.cq);
+    if (shm_.cq) io.UnRegister(shm_.cq);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const Net &net) {
+    os << "device addr:\n" << "  " << Addr2Str(net.addr_.efa) << "\n";
+    os << "shm addr:\n" << "  " << net.addr_.shm << "\n";
+    os << "remote addr:\n";
+    for (auto &c : net.conns_) os << "  " << c.first << "\n";
+    return os;
+  }
+
+ private:
+  Endpoint efa_;
+  Endpoint shm_;
+  NetAddr addr_{};
+  std::unordered_map<std::string, std::unique_ptr<Conn>> conns_;
+};
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief bfloat16 storage; arithmetic is done in fp32
+ */
+struct bf16 {
+  uint16_t bits;
+
+  inline static bf16 From(float f) {
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+    x += 0x7fff + ((x >> 16) & 1);  // round to nearest even
+    return bf16{(uint16_t)(x >> 16)};
+  }
+
+  inline float ToFloat() const {
+    uint32_t x = (uint32_t)bits << 16;
+    float f;
+    std::memcpy(&f, &x, sizeof(f));
+    return f;
+  }
+};
+
+/** @brief Reduction operator */
+enum class ReduceOp { kSum, kMax };
+
+/**
+ * @brief Elementwise reduction kernels (dst = op(dst, src))
+ *
+ * Kernels are compiled for AVX-512 and AVX2 with function target attributes and
+ * picked at runtime from cpuid, so the binary does not need -march flags and
+ * still runs on CPUs without AVX-512. bf16 is widened to fp32, reduced and
+ * rounded back to nearest even; NaN payloads are not preserved.
+ */
+struct Reduce {
+  /** @brief Instruction set used by the kernels */
+  enum ISA { kScalar, kAVX2, kAVX512 };
+
+  /**
+   * @brief Detect the widest instruction set supported by this CPU
+   * @return Instruction set used by Run()
+   */
+  inline static ISA Detect() {
+#if defined(__x86_64__)
+    static const ISA isa = [] {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f")) return kAVX512;
+      if (__builtin_cpu_supports("avx2")) return kAVX2;
+      return kScalar;
+    }();
+    return isa;
+#else
+    return kScalar;
+#endif
+  }
+
+  /** @brief Name of an instruction set */
+  inline static std::string_view Name(ISA isa) {
+    switch (isa) {
+      case kAVX512:
+        return "avx512";
+      case kAVX2:
+        return "avx2";
+      default:
+        return "scalar";
+    }
+  }
+
+  /**
+   * @brief Reduce src into dst
+   * @tparam T float, bf16, int32_t or int64_t
+   * @param op Reduction operator
+   * @param dst Accumulator, updated in place
+   * @param src Incoming values
+   * @param n Number of elements
+   */
+  template <typename T>
+  inline static void Run(ReduceOp op, T *dst, const T *src, size_t n) {
+    if (op == ReduceOp::kSum) {
+      Dispatch<T, ReduceOp::kSum>(dst, src, n);
+    } else {
+      Dispatch<T, ReduceOp::kMax>(dst, src, n);
+    }
+  }
+
+ private:
+  template <typename T, ReduceOp op>
+  inline static void Dispatch(T *dst, const T *src, size_t n) {
+#if defined(__x86_64__)
+    auto isa = Detect();
+    if (isa == kAVX512) return AVX512<op>(dst, src, n);
+    if (isa == kAVX2) return AVX2<op>(dst, src, n);
+#endif
+    Scalar<T, op>(dst, src, n, 0);
+  }
+
+  template <typename T, ReduceOp op>
+  inline static void Scalar(T *dst, const T *src, size_t n, size_t i) {
+    for (; i < n; ++i) {
+      if constexpr (std::is_same_v<T, bf16>) {
+        auto a = dst[i].ToFloat(), b = src[i].ToFloat();
+        dst[i] = bf16::From(op == ReduceOp::kSum ? a + b : (a < b ? b : a));
+      } else if constexpr (std::is_integral_v<T>) {
+        // wrap on overflow like the vector kernels instead of signed overflow UB
+        using U = std::make_unsigned_t<T>;
+        dst[i] = op == ReduceOp::kSum ? (T)((U)dst[i] + (U)src[i]) : (dst[i] < src[i] ? src[i] : dst[i]);
+      } else {
+        dst[i] = op == ReduceOp::kSum ? dst[i] + src[i] : (dst[i] < src[i] ? src[i] : dst[i]);
+      }
+    }
+  }
+
+#if defined(__x86_64__)
+// GCC 12 reports _mm512_undefined_* inside the intrinsics as uninitialized
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+  template <ReduceOp op>
+  __attribute__((target("avx512f"))) static void AVX512(float *dst, const float *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      auto a = _mm512_loadu_ps(dst + i), b = _mm512_loadu_ps(src + i);
+      _mm512_storeu_ps(dst + i, op == ReduceOp::kSum ? _mm512_add_ps(a, b) : _mm512_max_ps(a, b));
+    }
+    Scalar<float, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx512f"))) static void AVX512(int32_t *dst, const int32_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      auto a = _mm512_loadu_si512(dst + i), b = _mm512_loadu_si512(src + i);
+      _mm512_storeu_si512(dst + i, op == ReduceOp::kSum ? _mm512_add_epi32(a, b) : _mm512_max_epi32(a, b));
+    }
+    Scalar<int32_t, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx512f"))) static void AVX512(int64_t *dst, const int64_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      auto a = _mm512_loadu_si512(dst + i), b = _mm512_loadu_si512(src + i);
+      _mm512_storeu_si512(dst + i, op == ReduceOp::kSum ? _mm512_add_epi64(a, b) : _mm512_max_epi64(a, b));
+    }
+    Scalar<int64_t, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx512f"))) static void AVX512(bf16 *dst, const bf16 *src, size_t n) {
+    const auto one = _mm512_set1_epi32(1);
+    const auto bias = _mm512_set1_epi32(0x7fff);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      auto a = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)(dst + i))), 16));
+      auto b = _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)(src + i))), 16));
+      auto x = _mm512_castps_si512(op == ReduceOp::kSum ? _mm512_add_ps(a, b) : _mm512_max_ps(a, b));
+      auto lsb = _mm512_and_si512(_mm512_srli_epi32(x, 16), one);
+      x = _mm512_srli_epi32(_mm512_add_epi32(x, _mm512_add_epi32(lsb, bias)), 16);
+      _mm256_storeu_si256((__m256i *)(dst + i), _mm512_cvtepi32_epi16(x));
+    }
+    Scalar<bf16, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx2"))) static void AVX2(float *dst, const float *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      auto a = _mm256_loadu_ps(dst + i), b = _mm256_loadu_ps(src + i);
+      _mm256_storeu_ps(dst + i, op == ReduceOp::kSum ? _mm256_add_ps(a, b) : _mm256_max_ps(a, b));
+    }
+    Scalar<float, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx2"))) static void AVX2(int32_t *dst, const int32_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      auto a = _mm256_loadu_si256((const __m256i *)(dst + i)), b = _mm256_loadu_si256((const __m256i *)(src + i));
+      _mm256_storeu_si256((__m256i *)(dst + i), op == ReduceOp::kSum ? _mm256_add_epi32(a, b) : _mm256_max_epi32(a, b));
+    }
+    Scalar<int32_t, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx2"))) static void AVX2(int64_t *dst, const int64_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      auto a = _mm256_loadu_si256((const __m256i *)(dst + i)), b = _mm256_loadu_si256((const __m256i *)(src + i));
+      // AVX2 has no 64-bit max; select through a compare mask instead
+      auto r = op == ReduceOp::kSum ? _mm256_add_epi64(a, b) : _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+      _mm256_storeu_si256((__m256i *)(dst + i), r);
+    }
+    Scalar<int64_t, op>(dst, src, n, i);
+  }
+
+  template <ReduceOp op>
+  __attribute__((target("avx2"))) static void AVX2(bf16 *dst, const bf16 *src, size_t n) {
+    const auto one = _mm256_set1_epi32(1);
+    const auto bias = _mm256_set1_epi32(0x7fff);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      auto a = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(dst + i))), 16));
+      auto b = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(src + i))), 16));
+      auto x = _mm256_castps_si256(op == ReduceOp::kSum ? _mm256_add_ps(a, b) : _mm256_max_ps(a, b));
+      auto lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+      x = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(lsb, bias)), 16);
+      // packus works per 128-bit lane; gather the two low quadwords afterwards
+      auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(x, x), 0x08);
+      _mm_storeu_si128((__m128i *)(dst + i), _mm256_castsi256_si128(packed));
+    }
+    Scalar<bf16, op>(dst, src, n, i);
+  }
+#pragma GCC diagnostic pop
+#endif
+};
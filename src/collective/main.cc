@@ -0,0 +1,623 @@
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/allreduce.h"
+#include "common/alltoallv.h"
+#include "common/barrier.h"
+#include "common/broadcast.h"
+#include "common/channel.h"
+#include "common/clock.h"
+#include "common/comm.h"
+#include "common/heap.h"
+#include "common/coro.h"
+#include "common/mpi.h"
+#include "common/reduce.h"
+#include "common/runner.h"
+
+/**
+ * @brief Timing of one benchmark row, reduced across ranks
+ * @param elapse Seconds this rank spent in the timed iterations
+ * @return Slowest rank's time
+ */
+static double MaxAcrossRanks(double elapse) {
+  double out = 0;
+  MPI_Allreduce(&elapse, &out, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return out;
+}
+
+/**
+ * @brief Value rank r contributes at index i; small integers stay exact in bf16
+ */
+template <typename T>
+static T Init(int rank, size_t i) {
+  auto v = (int)((i + rank) % 4);
+  if constexpr (std::is_same_v<T, bf16>) {
+    return bf16::From((float)v);
+  } else {
+    return (T)v;
+  }
+}
+
+template <typename T>
+static double ToDouble(T v) {
+  if constexpr (std::is_same_v<T, bf16>) {
+    return v.ToFloat();
+  } else {
+    return (double)v;
+  }
+}
+
+/**
+ * @brief nccl-tests style allreduce sweep
+ *
+ * For every size the buffer is reduced kIters times after kWarmup untimed runs.
+ * algbw is size / time; busbw scales it by 2 * (n - 1) / n, the fraction of
+ * the data each rank has to move, so it is comparable with the link speed.
+ * A separate run on known inputs counts wrong elements.
+ */
+class AllreduceBench : private NoCopy {
+ public:
+  inline constexpr static size_t kWarmup = 5;
+  inline constexpr static size_t kIters = 20;
+
+  AllreduceBench(Comm &comm, size_t max_bytes, Allreduce::Algo algo) : comm_{comm}, barrier_{comm}, allreduce_{comm, max_bytes}, max_bytes_{max_bytes}, algo_{algo} {}
+
+  template <typename T>
+  Coro<> Run(std::string_view type, ReduceOp op) {
+    auto rank = comm_.GetRank();
+    auto n = comm_.GetSize();
+    auto name = algo_ == Allreduce::kRing ? "ring" : "halving";
+    if (rank == 0) {
+      std::cout << fmt::format("# nranks={} algo={} type={} op={} isa={}", n, name, type, op == ReduceOp::kSum ? "sum" : "max",
+                               Reduce::Name(Reduce::Detect()))
+                << std::endl;
+      std::cout << fmt::format("{:>12} {:>12} {:>12} {:>12} {:>12} {:>8}", "size(B)", "count", "time(us)", "algbw(GB/s)", "busbw(GB/s)", "#wrong")
+                << std::endl;
+    }
+    for (size_t bytes = 1024; bytes <= max_bytes_; bytes <<= 1) {
+      auto count = bytes / sizeof(T);
+      auto wrong = co_await Check<T>(count, op);
+
+      co_await barrier_.Run();
+      for (size_t i = 0; i < kWarmup; ++i) co_await allreduce_.Run<T>(count, op, algo_);
+      co_await barrier_.Run();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < kIters; ++i) co_await allreduce_.Run<T>(count, op, algo_);
+      auto end = std::chrono::steady_clock::now();
+      auto elapse = MaxAcrossRanks(std::chrono::duration<double>(end - start).count()) / kIters;
+
+      size_t total = 0;
+      MPI_Allreduce(&wrong, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+      if (rank != 0) continue;
+      auto algbw = bytes / elapse / 1e9;
+      auto busbw = algbw * 2 * (n - 1) / n;
+      std::cout << fmt::format("{:>12} {:>12} {:>12.2f} {:>12.3f} {:>12.3f} {:>8}", bytes, count, elapse * 1e6, algbw, busbw, total) << std::endl;
+    }
+  }
+
+ private:
+  template <typename T>
+  Coro<size_t> Check(size_t count, ReduceOp op) {
+    auto n = comm_.GetSize();
+    auto data = (T *)allreduce_.GetBuffer().GetData();
+    for (size_t i = 0; i < count; ++i) data[i] = Init<T>(comm_.GetRank(), i);
+    co_await barrier_.Run();
+    co_await allreduce_.Run<T>(count, op, algo_);
+    size_t wrong = 0;
+    for (size_t i = 0; i < count; ++i) {
+      double expect = op == ReduceOp::kSum ? 0 : ToDouble(Init<T>(0, i));
+      for (int r = 0; r < n; ++r) {
+        auto v = ToDouble(Init<T>(r, i));
+        expect = op == ReduceOp::kSum ? expect + v : std::max(expect, v);
+      }
+      if (ToDouble(data[i]) != expect) ++wrong;
+    }
+    co_return wrong;
+  }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  Allreduce allreduce_;
+  size_t max_bytes_;
+  Allreduce::Algo algo_;
+};
+
+Coro<> StartAllreduce(Allreduce::Algo algo, std::string type, ReduceOp op, size_t max_bytes) {
+  auto comm = Comm();
+  auto bench = AllreduceBench(comm, max_bytes, algo);
+  if (type == "float") {
+    co_await bench.Run<float>(type, op);
+  } else if (type == "bf16") {
+    co_await bench.Run<bf16>(type, op);
+  } else if (type == "int32") {
+    co_await bench.Run<int32_t>(type, op);
+  } else if (type == "int64") {
+    co_await bench.Run<int64_t>(type, op);
+  } else {
+    throw std::invalid_argument(fmt::format("unknown type {}", type));
+  }
+}
+
+/**
+ * @brief MoE-style alltoallv latency sweep over group sizes 2..N
+ *
+ * Every group size builds its own Alltoallv, plans imbalanced counts once (as
+ * an expert-parallel layer with a fixed routing would) and then times single
+ * exchanges. Per-step latencies are reduced to the slowest rank per iteration
+ * before avg/p50/p99 are taken, so a straggler shows up in the tail.
+ */
+class AlltoallvBench : private NoCopy {
+ public:
+  inline constexpr static size_t kWarmup = 5;
+
+  AlltoallvBench(Comm &comm, size_t bytes, size_t iters) : comm_{comm}, barrier_{comm}, bytes_{bytes}, iters_{iters} {}
+
+  Coro<> Run() {
+    auto rank = comm_.GetRank();
+    if (rank == 0) {
+      std::cout << fmt::format("# alltoallv bytes_per_peer={} iters={}", bytes_, iters_) << std::endl;
+      std::cout << fmt::format("{:>8} {:>14} {:>12} {:>12} {:>12} {:>8}", "nranks", "recv(B)", "avg(us)", "p50(us)", "p99(us)", "#wrong") << std::endl;
+    }
+    for (int group = 2; group <= comm_.GetSize(); ++group) co_await Sweep(group);
+  }
+
+ private:
+  /** @brief Bytes src sends to dst; uneven like tokens routed to popular experts */
+  inline size_t Count(int src, int dst) const noexcept { return bytes_ * (1 + (src * 7 + dst * 3) % 4) / 2; }
+
+  inline static char Pattern(int src, int dst, size_t i) noexcept { return (char)(src * 131 + dst * 31 + i); }
+
+  Coro<> Sweep(int group) {
+    auto rank = comm_.GetRank();
+    auto alltoallv = Alltoallv(comm_, group, 2 * bytes_ * group, 2 * bytes_ * group);
+    std::vector<double> lat(iters_, 0);
+    size_t wrong = 0, recv = 0;
+    if (alltoallv.IsMember()) {
+      std::vector<size_t> counts(group);
+      for (int dst = 0; dst < group; ++dst) counts[dst] = Count(rank, dst);
+      co_await alltoallv.Plan(counts);
+
+      auto send = (char *)alltoallv.GetSendBuffer().GetData();
+      auto &displs = alltoallv.GetSendDispls();
+      for (int dst = 0; dst < group; ++dst) {
+        for (size_t i = 0; i < counts[dst]; ++i) send[displs[dst] + i] = Pattern(rank, dst, i);
+      }
+      co_await alltoallv.Run();
+      auto out = alltoallv.GetRecvBuffer();
+      for (int src = 0; src < group; ++src) {
+        auto n = alltoallv.GetRecvCounts()[src];
+        if (n != Count(src, rank)) ++wrong;
+        for (size_t i = 0; i < n; ++i) {
+          if (out[alltoallv.GetRecvDispls()[src] + i] != Pattern(src, rank, i)) ++wrong;
+        }
+        recv += n;
+      }
+      for (size_t i = 0; i < kWarmup; ++i) co_await alltoallv.Run();
+    }
+
+    co_await barrier_.Run();
+    for (size_t i = 0; i < iters_; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      co_await alltoallv.Run();
+      auto end = std::chrono::steady_clock::now();
+      lat[i] = std::chrono::duration<double>(end - start).count();
+    }
+
+    std::vector<double> slowest(iters_, 0);
+    size_t total = 0, max_recv = 0;
+    MPI_Allreduce(lat.data(), slowest.data(), (int)iters_, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&wrong, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&recv, &max_recv, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+    if (rank != 0) co_return;
+    std::sort(slowest.begin(), slowest.end());
+    auto avg = std::accumulate(slowest.begin(), slowest.end(), 0.0) / iters_;
+    auto p50 = slowest[iters_ / 2];
+    auto p99 = slowest[std::min(iters_ - 1, iters_ * 99 / 100)];
+    std::cout << fmt::format("{:>8} {:>14} {:>12.2f} {:>12.2f} {:>12.2f} {:>8}", group, max_recv, avg * 1e6, p50 * 1e6, p99 * 1e6, total) << std::endl;
+  }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  size_t bytes_;
+  size_t iters_;
+};
+
+Coro<> StartAlltoallv(size_t bytes, size_t iters) {
+  auto comm = Comm();
+  auto bench = AlltoallvBench(comm, bytes, iters);
+  co_await bench.Run();
+}
+
+/**
+ * @brief Broadcast throughput sweep from rank 0
+ *
+ * Run() on the root returns once every rank acknowledged, so the root's time
+ * covers the whole broadcast. algbw is size / time; a pipelined chain should
+ * approach the link speed for large sizes regardless of the number of ranks.
+ */
+class BroadcastBench : private NoCopy {
+ public:
+  inline constexpr static size_t kWarmup = 2;
+  inline constexpr static size_t kIters = 10;
+
+  BroadcastBench(Comm &comm, size_t max_bytes, Broadcast::Topology topo) : comm_{comm}, barrier_{comm}, broadcast_{comm, max_bytes}, max_bytes_{max_bytes}, topo_{topo} {}
+
+  Coro<> Run() {
+    auto rank = comm_.GetRank();
+    if (rank == 0) {
+      std::cout << fmt::format("# nranks={} topo={} chunk={}", comm_.GetSize(), topo_ == Broadcast::kChain ? "chain" : "tree", Broadcast::kChunkSize)
+                << std::endl;
+      std::cout << fmt::format("{:>12} {:>12} {:>12} {:>8}", "size(B)", "time(us)", "algbw(GB/s)", "#wrong") << std::endl;
+    }
+    for (size_t bytes = 1 << 20; bytes <= max_bytes_; bytes <<= 1) {
+      auto wrong = co_await Check(bytes);
+
+      co_await barrier_.Run();
+      for (size_t i = 0; i < kWarmup; ++i) co_await broadcast_.Run(bytes, 0, topo_);
+      co_await barrier_.Run();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < kIters; ++i) co_await broadcast_.Run(bytes, 0, topo_);
+      auto end = std::chrono::steady_clock::now();
+      auto elapse = MaxAcrossRanks(std::chrono::duration<double>(end - start).count()) / kIters;
+
+      size_t total = 0;
+      MPI_Allreduce(&wrong, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+      if (rank != 0) continue;
+      std::cout << fmt::format("{:>12} {:>12.2f} {:>12.3f} {:>8}", bytes, elapse * 1e6, bytes / elapse / 1e9, total) << std::endl;
+    }
+  }
+
+ private:
+  Coro<size_t> Check(size_t bytes) {
+    auto data = (char *)broadcast_.GetBuffer().GetData();
+    auto pattern = [bytes](size_t i) { return (char)(i * 7 + bytes); };
+    if (comm_.GetRank() == 0) {
+      for (size_t i = 0; i < bytes; ++i) data[i] = pattern(i);
+    } else {
+      std::memset(data, 0, bytes);
+    }
+    co_await barrier_.Run();
+    co_await broadcast_.Run(bytes, 0, topo_);
+    size_t wrong = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+      if (data[i] != pattern(i)) ++wrong;
+    }
+    co_return wrong;
+  }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  Broadcast broadcast_;
+  size_t max_bytes_;
+  Broadcast::Topology topo_;
+};
+
+Coro<> StartBroadcast(Broadcast::Topology topo, size_t max_bytes) {
+  auto comm = Comm();
+  auto bench = BroadcastBench(comm, max_bytes, topo);
+  co_await bench.Run();
+}
+
+/**
+ * @brief Barrier latency, clock offsets and one-way write latency
+ *
+ * After Clock::Sync() every rank reads rank 0's clock, so rank 0 can stamp a
+ * write with its send time and the receiver can subtract it from the arrival
+ * time. The result is reported next to half the round trip to show how far
+ * the two differ, e.g. when the paths are asymmetric. Probes use steps 2 and 3
+ * of kTagClock.
+ */
+class ClockBench : private NoCopy {
+ public:
+  ClockBench(Comm &comm, size_t iters) : comm_{comm}, barrier_{comm}, clock_{comm}, probe_{kAlign}, iters_{iters} { probes_ = comm_.Expose(probe_); }
+
+  Coro<> Run() {
+    const int n = comm_.GetSize();
+    const int rank = comm_.GetRank();
+    co_await barrier_.Run();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iters_; ++i) co_await barrier_.Run();
+    auto end = std::chrono::steady_clock::now();
+    auto barrier = MaxAcrossRanks(std::chrono::duration<double>(end - start).count()) / iters_;
+
+    co_await clock_.Sync();
+    std::vector<double> one_way(n, 0), rtt(n, 0);
+    for (int peer = 1; peer < n; ++peer) {
+      if (rank == 0) {
+        auto [o, r] = co_await Probe(peer);
+        one_way[peer] = o;
+        rtt[peer] = r;
+      } else if (rank == peer) {
+        co_await Answer();
+      }
+    }
+
+    std::vector<int64_t> offsets(n), errors(n);
+    int64_t offset = clock_.GetOffset(), error = clock_.GetError();
+    MPI_Gather(&offset, 1, MPI_INT64_T, offsets.data(), 1, MPI_INT64_T, 0, MPI_COMM_WORLD);
+    MPI_Gather(&error, 1, MPI_INT64_T, errors.data(), 1, MPI_INT64_T, 0, MPI_COMM_WORLD);
+    if (rank != 0) co_return;
+    std::cout << fmt::format("# nranks={} barrier={:.2f}us rounds={}", n, barrier * 1e6, std::bit_width((unsigned)n - 1)) << std::endl;
+    std::cout << fmt::format("{:>8} {:>16} {:>12} {:>14} {:>14}", "rank", "offset(ns)", "error(ns)", "one-way(us)", "rtt/2(us)") << std::endl;
+    for (int peer = 1; peer < n; ++peer) {
+      std::cout << fmt::format("{:>8} {:>16} {:>12} {:>14.2f} {:>14.2f}", peer, offsets[peer], errors[peer], one_way[peer], rtt[peer] / 2) << std::endl;
+    }
+  }
+
+ private:
+  /** @brief Send stamped writes to a peer; returns average one-way latency and round trip in us */
+  Coro<std::pair<double, double>> Probe(int peer) {
+    auto &conn = *comm_.GetConn(peer);
+    auto &dst = probes_[peer];
+    double rtt = 0;
+    for (size_t i = 0; i < iters_; ++i) {
+      auto t0 = clock_.Now();
+      std::memcpy(probe_.GetData(), &t0, sizeof(t0));
+      co_await conn.Write(probe_, 0, sizeof(t0), dst.addr, dst.key, Comm::Imm(kTagClock, 2, peer));
+      co_await conn.Read(Comm::Imm(kTagClock, 3, peer));
+      rtt += (clock_.Now() - t0) / 1e3;
+    }
+    double one_way = 0;
+    co_await conn.Read(Comm::Imm(kTagClock, 3, peer));
+    std::memcpy(&one_way, probe_.GetData(), sizeof(one_way));
+    co_return std::pair{one_way, rtt / iters_};
+  }
+
+  /** @brief Receive stamped writes from rank 0 and report the average one-way latency */
+  Coro<> Answer() {
+    const int rank = comm_.GetRank();
+    auto &conn = *comm_.GetConn(0);
+    auto &dst = probes_[0];
+    double total = 0;
+    for (size_t i = 0; i < iters_; ++i) {
+      co_await conn.Read(Comm::Imm(kTagClock, 2, rank));
+      auto t1 = clock_.Now();
+      int64_t t0;
+      std::memcpy(&t0, probe_.GetData(), sizeof(t0));
+      total += (t1 - t0) / 1e3;
+      co_await conn.Write(probe_, 0, 0, dst.addr, dst.key, Comm::Imm(kTagClock, 3, rank));
+    }
+    double one_way = total / iters_;
+    std::memcpy(probe_.GetData(), &one_way, sizeof(one_way));
+    co_await conn.Write(probe_, 0, sizeof(one_way), dst.addr, dst.key, Comm::Imm(kTagClock, 3, rank));
+  }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  Clock clock_;
+  Memory probe_;
+  size_t iters_;
+  std::vector<Region> probes_;
+};
+
+Coro<> StartClock(size_t iters) {
+  auto comm = Comm();
+  auto bench = ClockBench(comm, iters);
+  co_await bench.Run();
+}
+
+/**
+ * @brief Ring shift over the symmetric heap
+ *
+ * Every rank puts a block into the same offset on its right neighbour and
+ * signals the last put of an iteration; the neighbour waits for the signal
+ * before the next round, so the measured bandwidth includes delivery. A Get()
+ * of 8 bytes from the right neighbour measures the read round trip.
+ */
+class HeapBench : private NoCopy {
+ public:
+  HeapBench(Comm &comm, size_t max_bytes, size_t iters)
+      : comm_{comm}, barrier_{comm}, heap_{comm, 2 * max_bytes + kAlign}, max_bytes_{max_bytes}, iters_{iters} {
+    src_ = heap_.Alloc(max_bytes_);
+    dst_ = heap_.Alloc(max_bytes_);
+    word_ = heap_.Alloc(sizeof(uint64_t));
+  }
+
+  Coro<> Run() {
+    const int n = comm_.GetSize();
+    const int rank = comm_.GetRank();
+    const int right = (rank + 1) % n;
+    const int left = (rank + n - 1) % n;
+    if (rank == 0) {
+      std::cout << fmt::format("# nranks={} iters={}", n, iters_) << std::endl;
+      std::cout << fmt::format("{:>12} {:>12} {:>12} {:>12} {:>8}", "size(B)", "put(us)", "put(GB/s)", "get8(us)", "#wrong") << std::endl;
+    }
+    auto src = heap_.Ptr(src_);
+    auto dst = heap_.Ptr(dst_);
+    uint32_t signal = 0;
+    for (size_t bytes = 8; bytes <= max_bytes_; bytes <<= 2) {
+      for (size_t i = 0; i < bytes; ++i) src[i] = Pattern(rank, i);
+      std::memset(dst, 0, bytes);
+      co_await barrier_.Run();
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < iters_; ++i, signal = (signal + 1) & Heap::kMaxSignal) {
+        co_await heap_.PutSignal(right, dst_, src, bytes, signal);
+        co_await heap_.WaitSignal(left, signal);
+      }
+      co_await heap_.Quiet();
+      auto end = std::chrono::steady_clock::now();
+      auto put = MaxAcrossRanks(std::chrono::duration<double>(end - start).count()) / iters_;
+
+      size_t wrong = 0;
+      for (size_t i = 0; i < bytes; ++i) {
+        if (dst[i] != Pattern(left, i)) ++wrong;
+      }
+
+      co_await barrier_.Run();
+      start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < iters_; ++i) co_await heap_.Get(right, src_, heap_.Ptr(word_), sizeof(uint64_t));
+      end = std::chrono::steady_clock::now();
+      auto get = MaxAcrossRanks(std::chrono::duration<double>(end - start).count()) / iters_;
+      co_await barrier_.Run();
+
+      size_t total = 0;
+      MPI_Allreduce(&wrong, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+      if (rank != 0) continue;
+      std::cout << fmt::format("{:>12} {:>12.2f} {:>12.3f} {:>12.2f} {:>8}", bytes, put * 1e6, bytes / put / 1e9, get * 1e6, total) << std::endl;
+    }
+  }
+
+ private:
+  inline static char Pattern(int rank, size_t i) noexcept { return (char)(rank * 17 + i); }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  Heap heap_;
+  size_t max_bytes_;
+  size_t iters_;
+  size_t src_;
+  size_t dst_;
+  size_t word_;
+};
+
+Coro<> StartHeap(size_t max_bytes, size_t iters) {
+  auto comm = Comm();
+  auto bench = HeapBench(comm, max_bytes, iters);
+  co_await bench.Run();
+}
+
+/**
+ * @brief Record streaming from even to odd ranks
+ *
+ * Rank 2i pushes records into a Channel read by rank 2i + 1. Every record
+ * starts with its sequence number followed by a pattern, which the consumer
+ * checks before popping the next one.
+ */
+class StreamBench : private NoCopy {
+ public:
+  inline constexpr static size_t kSlots = 256;
+
+  StreamBench(Comm &comm, size_t record, size_t records) : comm_{comm}, barrier_{comm}, record_{std::max(record, sizeof(uint64_t))}, records_{records} {
+    for (int p = 0; p + 1 < comm_.GetSize(); p += 2) {
+      channels_.emplace_back(std::make_unique<Channel>(comm_, p, p + 1, p / 2, kSlots, Channel::kHeader + record_));
+    }
+  }
+
+  Coro<> Run() {
+    const int rank = comm_.GetRank();
+    const int n = comm_.GetSize();
+    double rate = 0;
+    size_t wrong = 0;
+    co_await barrier_.Run();
+    if ((size_t)rank / 2 < channels_.size()) {
+      auto &channel = *channels_[rank / 2];
+      if (rank % 2 == 0) {
+        std::vector<char> data(record_);
+        for (size_t i = 0; i < record_; ++i) data[i] = (char)(i * 13);
+        for (uint64_t seq = 0; seq < records_; ++seq) {
+          std::memcpy(data.data(), &seq, sizeof(seq));
+          co_await channel.Push(data.data(), data.size());
+        }
+        co_await channel.Flush();
+      } else {
+        std::chrono::steady_clock::time_point start;
+        for (uint64_t seq = 0; seq < records_; ++seq) {
+          auto view = co_await channel.Pop();
+          if (seq == 0) start = std::chrono::steady_clock::now();
+          uint64_t got;
+          std::memcpy(&got, view.data(), sizeof(got));
+          if (view.size() != record_ or got != seq) ++wrong;
+          for (size_t i = sizeof(got); i < view.size(); ++i) {
+            if (view[i] != (char)(i * 13)) ++wrong;
+          }
+        }
+        auto end = std::chrono::steady_clock::now();
+        rate = (records_ - 1) / std::chrono::duration<double>(end - start).count();
+        co_await channel.Flush();
+      }
+    }
+    co_await barrier_.Run();
+
+    std::vector<double> rates(n);
+    size_t total = 0;
+    MPI_Gather(&rate, 1, MPI_DOUBLE, rates.data(), 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&wrong, &total, 1, MPI_UNSIGNED_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank != 0) co_return;
+    std::cout << fmt::format("# pairs={} record={} records={} slots={} #wrong={}", channels_.size(), record_, records_, kSlots, total) << std::endl;
+    std::cout << fmt::format("{:>12} {:>14} {:>12}", "pair", "Mrecords/s", "GB/s") << std::endl;
+    double sum = 0;
+    for (size_t p = 0; p < channels_.size(); ++p) {
+      auto r = rates[2 * p + 1];
+      sum += r;
+      std::cout << fmt::format("{:>12} {:>14.3f} {:>12.3f}", fmt::format("{}->{}", 2 * p, 2 * p + 1), r / 1e6, r * record_ / 1e9) << std::endl;
+    }
+    std::cout << fmt::format("{:>12} {:>14.3f} {:>12.3f}", "total", sum / 1e6, sum * record_ / 1e9) << std::endl;
+  }
+
+ private:
+  Comm &comm_;
+  Barrier barrier_;
+  size_t record_;
+  size_t records_;
+  std::vector<std::unique_ptr<Channel>> channels_;
+};
+
+Coro<> StartStream(size_t record, size_t records) {
+  auto comm = Comm();
+  auto bench = StreamBench(comm, record, records);
+  co_await bench.Run();
+}
+
+/**
+ * usage: collective allreduce [ring|halving] [float|bf16|int32|int64] [sum|max] [max_bytes]
+ *        collective alltoallv [bytes_per_peer] [iters]
+ *        collective broadcast [chain|tree] [max_bytes]
+ *        collective clock [iters]
+ *        collective heap [max_bytes] [iters]
+ *        collective stream [record_bytes] [records]
+ *
+ * All ranks connect to each other, through shm on one node, so the benchmark
+ * runs on a single machine: mpirun -np 8 ./collective allreduce ring float
+ */
+int main(int argc, char *argv[]) {
+  auto &mpi = MPI::Get();
+  ASSERT(mpi.GetWorldSize() >= 2);
+
+  std::string cmd = argc > 1 ? argv[1] : "allreduce";
+  if (cmd == "allreduce") {
+    auto algo = argc > 2 and std::string_view(argv[2]) == "halving" ? Allreduce::kHalving : Allreduce::kRing;
+    std::string type = argc > 3 ? argv[3] : "float";
+    auto op = argc > 4 and std::string_view(argv[4]) == "max" ? ReduceOp::kMax : ReduceOp::kSum;
+    size_t max_bytes = argc > 5 ? std::stoul(argv[5]) : 64UL << 20;
+    Run(StartAllreduce(algo, type, op, max_bytes));
+  } else if (cmd == "alltoallv") {
+    size_t bytes = argc > 2 ? std::stoul(argv[2]) : 64UL << 10;
+    size_t iters = argc > 3 ? std::stoul(argv[3]) : 100;
+    ASSERT(iters > 0);
+    Run(StartAlltoallv(bytes, iters));
+  } else if (cmd == "broadcast") {
+    auto topo = argc > 2 and std::string_view(argv[2]) == "tree" ? Broadcast::kTree : Broadcast::kChain;
+    size_t max_bytes = argc > 3 ? std::stoul(argv[3]) : 256UL << 20;
+    Run(StartBroadcast(topo, max_bytes));
+  } else if (cmd == "clock") {
+    size_t iters = argc > 2 ? std::stoul(argv[2]) : 1000;
+    ASSERT(iters > 0);
+    Run(StartClock(iters));
+  } else if (cmd == "heap") {
+    size_t max_bytes = argc > 2 ? std::stoul(argv[2]) : 4UL << 20;
+    size_t iters = argc > 3 ? std::stoul(argv[3]) : 100;
+    ASSERT(iters > 0);
+    Run(StartHeap(max_bytes, iters));
+  } else if (cmd == "stream") {
+    size_t record = argc > 2 ? std::stoul(argv[2]) : 4096;
+    size_t records = argc > 3 ? std::stoul(argv[3]) : 1000000;
+    ASSERT(records > 1);
+    Run(StartStream(record, records));
+  } else {
+    throw std::invalid_argument(fmt::format("unknown collective {}", cmd));
+  }
+}
@@ -0,0 +1,80 @@
+#include "common/net.h"
+
+#include "common/mpi.h"
+
+Conn *Net::Connect(const char *remote, size_t window) {
+  auto addr = (const NetAddr *)remote;
+  auto local = IsLocal(remote);
+  auto &e = local ? shm_ : efa_;
+  ASSERT(!!e.ep);
+  fi_addr_t fi_addr = FI_ADDR_UNSPEC;
+  if (local) {
+    EXPECT(fi_av_insert(e.av, addr->shm, 1, &fi_addr, 0, nullptr), 1);
+  } else {
+    EXPECT(fi_av_insert(e.av, addr->efa, 1, &fi_addr, 0, nullptr), 1);
+  }
+  auto key = local ? std::string(addr->shm) : Addr2Str(addr->efa);
+  auto conn = std::make_unique<Conn>(e.ep, e.domain, fi_addr, window);
+  auto raw_conn = conn.get();
+  conns_.emplace(key, std::move(conn));
+  return raw_conn;
+}
+
+void Net::Open(struct fi_info *info, struct fi_info *shm) {
+  ASSERT(info or shm);
+  addr_.node = MPI::Get().GetNodeIndex();
+  if (info) Open(info, efa_, addr_.efa, sizeof(addr_.efa));
+  if (shm) Open(shm, shm_, addr_.shm, sizeof(addr_.shm) - 1);
+  Register();
+}
+
+void Net::Open(struct fi_info *info, Endpoint &e, char *addr, size_t len) {
+  struct fi_av_attr av_attr{};
+  struct fi_cq_attr cq_attr{};
+
+  CHECK(fi_fabric(info->fabric_attr, &e.fabric, nullptr));
+  CHECK(fi_domain(e.fabric, info, &e.domain, nullptr));
+
+  cq_attr.format = FI_CQ_FORMAT_DATA;
+  CHECK(fi_cq_open(e.domain, &cq_attr, &e.cq, nullptr));
+  CHECK(fi_av_open(e.domain, &av_attr, &e.av, nullptr));
+  CHECK(fi_endpoint(e.domain, info, &e.ep, nullptr));
+  CHECK(fi_ep_bind(e.ep, &e.cq->fid, FI_SEND | FI_RECV));
+  CHECK(fi_ep_bind(e.ep, &e.av->fid, 0));
+  CHECK(fi_enable(e.ep));
+  CHECK(fi_getname(&e.ep->fid, addr, &len));
+}
+
+void Net::Close(Endpoint &e) {
+  if (e.ep) {
+    fi_close((fid_t)e.ep);
+    e.ep = nullptr;
+  }
+  if (e.cq) {
+    fi_close((fid_t)e.cq);
+    e.cq = nullptr;
+  }
+  if (e.av) {
+    fi_close((fid_t)e.av);
+    e.av = nullptr;
+  }
+  if (e.domain) {
+    fi_close((fid_t)e.domain);
+    e.domain = nullptr;
+  }
+  if (e.fabric) {
+    fi_close((fid_t)e.fabric);
+    e.fabric = nullptr;
+  }
+}
+
+Net::~Net() {
+  UnRegister();
+  // close endpoints first so no receive is posted into a freed slot, then
+  // drop connections, which own memory regions of the domains closed below
+  if (efa_.ep) fi_close((fid_t)std::exchange(efa_.ep, nullptr));
+  if (shm_.ep) fi_close((fid_t)std::exchange(shm_.ep, nullptr));
+  conns_.clear();
+  Close(shm_);
+  Close(efa_);
+}
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+set -exo pipefail
+
+DIR="$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+sqsh="${DIR}/../../efa+latest.sqsh"
+mount="/fsx:/fsx"
+binary="${DIR}/../../build/src/collective/collective"
+
+# eight ranks on one node talk through the shm provider; raise --nodes to
+# mix shm and EFA connections
+for algo in ring halving; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --nodes=1 \
+    --ntasks-per-node=8 \
+    "${binary}" allreduce "${algo}" float sum
+done
+
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --nodes=1 \
+  --ntasks-per-node=8 \
+  "${binary}" alltoallv 65536 100
+
+for topo in chain tree; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --nodes=1 \
+    --ntasks-per-node=8 \
+    "${binary}" broadcast "${topo}"
+done
+
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --nodes=1 \
+  --ntasks-per-node=8 \
+  "${binary}" clock
+
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --nodes=1 \
+  --ntasks-per-node=8 \
+  "${binary}" heap
+
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --nodes=1 \
+  --ntasks-per-node=8 \
+  "${binary}" stream 4096 1000000
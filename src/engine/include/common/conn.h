@@ -0,0 +1,437 @@
+#pragma once
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+#include "common/buffer.h"
+#include "common/coro.h"
+#include "common/event.h"
+#include "common/future.h"
+#include "common/utils.h"
+
+/**
+ * @brief Remote memory region advertised by a peer
+ */
+struct Region {
+  uint64_t addr;
+  uint64_t size;
+  uint64_t key;
+};
+
+/**
+ * @brief Segment size and pipeline depth used by Conn::Transfer
+ *
+ * The pipeline keeps at least two bandwidth-delay products in flight (and
+ * never less than kMinInflight, which is what saturates EFA in practice), split
+ * into about kDepth segments bounded by the provider's max_msg_size.
+ */
+struct Pipeline {
+  size_t segment;  ///< Bytes per RMA write
+  size_t depth;    ///< RMA writes kept in flight
+
+  inline constexpr static size_t kMinSegment = 64 << 10;
+  inline constexpr static size_t kMaxSegment = 1 << 20;
+  inline constexpr static size_t kMinInflight = 2 << 20;
+  inline constexpr static size_t kDepth = 8;
+  inline constexpr static size_t kMaxDepth = 64;
+
+  /**
+   * @brief Derive segment size and depth from the link
+   * @param speed Link speed in bits per second (0 if unknown)
+   * @param max_msg_size Largest message the endpoint accepts (0 if unknown)
+   * @param rtt Observed round-trip time
+   * @return Pipeline parameters
+   */
+  inline static Pipeline Tune(size_t speed, size_t max_msg_size, std::chrono::nanoseconds rtt) {
+    auto bdp = speed / 8 * rtt.count() / 1000000000;
+    auto inflight = std::max<size_t>(2 * bdp, kMinInflight);
+    auto limit = max_msg_size ? std::min(max_msg_size, kMaxSegment) : kMaxSegment;
+    auto segment = std::bit_floor(std::clamp(inflight / kDepth, std::min(kMinSegment, limit), limit));
+    auto depth = std::clamp<size_t>((inflight + segment - 1) / segment, 2, kMaxDepth);
+    return {segment, depth};
+  }
+};
+
+/**
+ * @brief RDMA connection with coroutine-based async I/O
+ */
+class Conn : private NoCopy {
+ public:
+  /**
+   * @brief Create connection with endpoint and buffers
+   * @param ep Fabric endpoint handle
+   * @param domain RDMA domain for buffer registration
+   * @param remote Remote endpoint address
+   * @param info Fabric info of the endpoint, used to size Transfer segments
+   */
+  Conn(struct fid_ep *ep, struct fid_domain *domain, fi_addr_t remote, struct fi_info *info = nullptr)
+      : ep_{ep},
+        remote_{remote},
+        recv_buffer_{HostBuffer(domain, kBufferSize)},
+        send_buffer_{HostBuffer(domain, kBufferSize)},
+        read_buffer_{CUDABuffer(domain, kMemoryRegionSize)},
+        write_buffer_{CUDABuffer(domain, kMemoryRegionSize)} {
+    if (info and info->nic and info->nic->link_attr) speed_ = info->nic->link_attr->speed;
+    if (info and info->ep_attr) max_msg_size_ = info->ep_attr->max_msg_size;
+    pipeline_ = Pipeline::Tune(speed_, max_msg_size_, rtt_);
+  }
+
+  /**
+   * @brief Awaiter for asynchronous receive operations
+   * Suspends coroutine until RDMA receive completes
+   */
+  struct recv_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    size_t size{0};
+    recv_awaiter(Conn *c, size_t sz) : conn{c}, size{sz} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      struct iovec iov{0};
+      struct fi_msg msg{0};
+      auto &buffer = conn->recv_buffer_;
+      iov.iov_base = buffer.GetData();
+      iov.iov_len = size;
+      msg.msg_iov = &iov;
+      msg.desc = &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = FI_ADDR_UNSPEC;
+      msg.context = &context;
+      CHECK(fi_recvmsg(conn->ep_, &msg, 0));
+      return true;
+    }
+
+    std::pair<char *, size_t> await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_recv = (flags & FI_RECV);
+      if (!is_recv) throw std::runtime_error(fmt::format("Invalid cq recv flags."));
+      char *buf = (char *)conn->recv_buffer_.GetData();
+      auto len = entry.len;
+      return {buf, len};
+    }
+  };
+
+  /**
+   * @brief Awaiter for asynchronous send operations
+   * Suspends coroutine until RDMA send completes
+   */
+  struct send_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    size_t size{0};
+    send_awaiter(Conn *c, size_t sz) : conn{c}, size{sz} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &buffer = conn->send_buffer_;
+      struct iovec iov{0};
+      struct fi_msg msg{0};
+      iov.iov_base = buffer.GetData();
+      iov.iov_len = size;
+      msg.msg_iov = &iov;
+      msg.desc = &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = conn->remote_;
+      msg.context = &context;
+      CHECK(fi_sendmsg(conn->ep_, &msg, 0));
+      return true;
+    }
+
+    size_t await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_send = (flags & FI_SEND);
+      if (!is_send) throw std::runtime_error(fmt::format("Invalid cq send flags."));
+      return entry.len;
+    }
+  };
+
+  /**
+   * @brief Coroutine awaiter for asynchronous operations
+   */
+  struct write_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    const char *data{0};
+    size_t size{0};
+    uint64_t addr{0};
+    uint64_t key{0};
+    uint64_t imm_data{0};
+    write_awaiter(Conn *c, const char *d, size_t sz, uint64_t a, uint64_t k, uint64_t i)
+        : conn{c}, data{d}, size{sz}, addr{a}, key{k}, imm_data{i} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &buffer = conn->write_buffer_;
+      struct iovec iov;
+      struct fi_rma_iov rma_iov;
+      struct fi_msg_rma msg;
+      iov.iov_base = (void *)data;
+      iov.iov_len = size;
+      rma_iov.addr = addr;
+      rma_iov.len = size;
+      rma_iov.key = key;
+      msg.msg_iov = &iov;
+      msg.desc = &buffer.GetMR()->mem_desc;
+      msg.iov_count = 1;
+      msg.addr = conn->remote_;
+      msg.rma_iov = &rma_iov;
+      msg.rma_iov_count = 1;
+      msg.context = &context;
+      msg.data = imm_data;
+      uint64_t flags = 0;
+      if (imm_data) flags |= FI_REMOTE_CQ_DATA;
+      CHECK(fi_writemsg(conn->ep_, &msg, flags));
+      return true;
+    }
+
+    size_t await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_write = (flags & FI_WRITE);
+      if (!is_write) throw std::runtime_error(fmt::format("Invalid cq write flags."));
+      return entry.len;
+    }
+  };
+
+  /**
+   * @brief Coroutine awaiter for asynchronous operations
+   */
+  struct remote_write_awaiter {
+    Conn *conn{0};
+    Context context{0};
+    uint64_t imm_data{0};
+    remote_write_awaiter(Conn *c, uint64_t i) : conn{c}, imm_data{i} {}
+    constexpr bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    bool await_suspend(std::coroutine_handle<Promise> coroutine) {
+      coroutine.promise().SetState(Handle::kSuspend);
+      context.handle = &coroutine.promise();
+      auto &io = IO::Get();
+      if (io.Claim(imm_data, &context)) return false;
+      io.Register(imm_data, &context);
+      return true;
+    }
+
+    char *await_resume() {
+      auto &entry = context.entry;
+      auto flags = entry.flags;
+      bool is_remote_write = (flags & FI_REMOTE_WRITE);
+      if (!is_remote_write) throw std::runtime_error(fmt::format("Invalid remote write flags."));
+      IO::Get().UnRegister(imm_data);
+      return (char *)conn->read_buffer_.GetData();
+    }
+  };
+
+  /**
+   * @brief Asynchronously receive data
+   * @param sz Maximum bytes to receive (default: kBufferSize)
+   * @return Coroutine yielding {buffer_ptr, actual_size}
+   * @throws std::invalid_argument if sz <= 0
+   */
+  Coro<std::pair<char *, size_t>> Recv(size_t sz = kBufferSize) { return Recv(oneway, sz); }
+
+  /**
+   * @brief Asynchronously send data
+   * @param data Data buffer to send
+   * @param sz Number of bytes to send
+   * @return Coroutine yielding bytes sent
+   * @throws std::invalid_argument if data is NULL or sz <= 0
+   */
+  Coro<size_t> Send(const char *data, size_t sz) { return Send(oneway, data, sz); }
+
+  Coro<size_t> Write(const char *data, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
+    return Write(oneway, data, sz, addr, key, imm_data);
+  }
+
+  Coro<char *> Read(uint64_t imm_data) { return Read(oneway, imm_data); }
+
+  /**
+   * @brief Write an arbitrary-size payload to a remote region
+   *
+   * The payload is split into Pipeline::segment sized RMA writes with up to
+   * Pipeline::depth in flight. Only the last segment carries imm_data and it
+   * is posted after every other segment completed, since RDM writes may land
+   * out of order; the peer's Read(imm_data) therefore resumes once the whole
+   * payload landed. The observed RTT retunes the pipeline after each transfer.
+   *
+   * @param src Payload inside the write buffer
+   * @param len Payload size in bytes
+   * @param region Destination region (len must fit in region.size)
+   * @param imm_data Completion immediate data for the last segment
+   * @return Coroutine yielding bytes written
+   * @throws std::invalid_argument on a bad source or destination
+   */
+  Coro<size_t> Transfer(const char *src, size_t len, const Region &region, uint64_t imm_data) {
+    return Transfer(oneway, src, len, region, imm_data);
+  }
+
+  /**
+   * @brief Write pages so that the peer can consume each one as it lands
+   *
+   * Every group of pages becomes one RMA write tagged with
+   * (prefix << 16) | group index, with as many writes in flight as the
+   * current Pipeline keeps bytes in flight. The peer tracks them with an
+   * Arrivals subscribed to prefix instead of waiting for the whole payload.
+   *
+   * @param src First page inside the write buffer
+   * @param page_size Page size in bytes
+   * @param num_pages Number of pages
+   * @param region Destination region
+   * @param prefix Upper 16 bits of every immediate data (non-zero)
+   * @param group Pages per write and per immediate
+   * @return Coroutine yielding bytes written
+   * @throws std::invalid_argument on a bad source, destination or prefix
+   */
+  Coro<size_t> TransferPages(const char *src, size_t page_size, size_t num_pages, const Region &region, uint32_t prefix, size_t group = 1) {
+    return TransferPages(oneway, src, page_size, num_pages, region, prefix, group);
+  }
+
+  /** @brief Get send buffer reference */
+  inline HostBuffer &GetSendBuffer() noexcept { return send_buffer_; }
+  /** @brief Get receive buffer reference */
+  inline HostBuffer &GetRecvBuffer() noexcept { return recv_buffer_; }
+  /** @brief Get CUDA write buffer reference */
+  inline CUDABuffer &GetWriteBuffer() noexcept { return write_buffer_; }
+  /** @brief Get CUDA read buffer reference */
+  inline CUDABuffer &GetReadBuffer() noexcept { return read_buffer_; }
+  /** @brief Get current Transfer segmentation */
+  inline const Pipeline &GetPipeline() const noexcept { return pipeline_; }
+  /** @brief Get smoothed round-trip time observed by Transfer */
+  inline std::chrono::nanoseconds GetRTT() const noexcept { return rtt_; }
+
+ private:
+  /**
+   * @brief Asynchronously receive data
+   * @param sz Maximum bytes to receive (default: kBufferSize)
+   * @return Coroutine yielding {buffer_ptr, actual_size}
+   * @throws std::invalid_argument if sz <= 0
+   */
+  Coro<std::pair<char *, size_t>> Recv(Oneway, size_t sz = kBufferSize) {
+    if (sz <= 0) throw std::invalid_argument("Recv buffer size should be greater than 0");
+    co_return co_await recv_awaiter(this, sz);
+  }
+
+  /**
+   * @brief Asynchronously send data
+   * @param data Data buffer to send
+   * @param sz Number of bytes to send
+   * @return Coroutine yielding bytes sent
+   * @throws std::invalid_argument if data is NULL or sz <= 0
+   */
+  Coro<size_t> Send(Oneway, const char *data, size_t sz) {
+    if (!data) throw std::invalid_argument("Send data is NULL");
+    if (sz <= 0) throw std::invalid_argument("Send buffer size should be greater than 0");
+    auto buffer = send_buffer_.GetData();
+    std::memcpy(buffer, data, sz);
+    co_return co_await send_awaiter(this, sz);
+  }
+
+  Coro<size_t> Write(Oneway, const char *data, size_t sz, uint64_t addr, uint64_t key, uint64_t imm_data = 0) {
+    if (!data) throw std::invalid_argument("Write data is NULL");
+    if (sz <= 0) throw std::invalid_argument("Write buffer size should be greater than 0");
+    co_return co_await write_awaiter(this, data, sz, addr, key, imm_data);
+  }
+
+  Coro<size_t> Transfer(Oneway, const char *src, size_t len, Region region, uint64_t imm_data) {
+    using clock = std::chrono::steady_clock;
+    auto base = (const char *)write_buffer_.GetData();
+    if (!src or src < base or src + len > base + write_buffer_.GetSize()) throw std::invalid_argument("Transfer source outside write buffer");
+    if (len <= 0) throw std::invalid_argument("Transfer size should be greater than 0");
+    if (len > region.size) throw std::invalid_argument("Transfer size exceeds remote region");
+    if (imm_data == 0) throw std::invalid_argument("imm_data should be greater than 0");
+
+    auto [segment, depth] = pipeline_;
+    std::deque<std::pair<Future<Coro<size_t>>, clock::time_point>> futs;
+    auto sample = clock::duration::max();
+    for (size_t off = 0; off < len; off += segment) {
+      while (futs.size() >= depth) {
+        co_await futs.front().first;
+        sample = std::min(sample, clock::now() - futs.front().second);
+        futs.pop_front();
+      }
+      auto sz = std::min(segment, len - off);
+      auto is_final = off + sz == len;
+      while (is_final and !futs.empty()) {
+        co_await futs.front().first;
+        sample = std::min(sample, clock::now() - futs.front().second);
+        futs.pop_front();
+      }
+      auto start = clock::now();
+      futs.emplace_back(Future(Write(src + off, sz, region.addr + off, region.key, is_final ? imm_data : 0)), start);
+    }
+    for (auto &[fut, start] : futs) {
+      co_await fut;
+      sample = std::min(sample, clock::now() - start);
+    }
+
+    // the fastest completion approximates one RTT plus the segment's serialization
+    auto wire = speed_ ? std::chrono::nanoseconds(segment * 8 * 1000000000 / speed_) : std::chrono::nanoseconds(0);
+    auto rtt = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(sample) - wire, std::chrono::nanoseconds(0));
+    rtt_ = (rtt_ * 7 + rtt) / 8;
+    pipeline_ = Pipeline::Tune(speed_, max_msg_size_, rtt_);
+    co_return len;
+  }
+
+  Coro<size_t> TransferPages(Oneway, const char *src, size_t page_size, size_t num_pages, Region region, uint32_t prefix, size_t group) {
+    auto base = (const char *)write_buffer_.GetData();
+    auto len = page_size * num_pages;
+    if (!src or src < base or src + len > base + write_buffer_.GetSize()) throw std::invalid_argument("TransferPages source outside write buffer");
+    if (len <= 0 or group <= 0) throw std::invalid_argument("TransferPages size should be greater than 0");
+    if (len > region.size) throw std::invalid_argument("TransferPages size exceeds remote region");
+    if (prefix == 0 or prefix > 0xffff) throw std::invalid_argument("TransferPages prefix should be in [1, 0xffff]");
+    auto bytes = page_size * group;
+    if (max_msg_size_ and bytes > max_msg_size_) throw std::invalid_argument("TransferPages group exceeds max_msg_size");
+    auto groups = (num_pages + group - 1) / group;
+    if (groups > (1 << 16)) throw std::invalid_argument("TransferPages needs a larger group");
+
+    auto depth = std::max<size_t>(2, pipeline_.segment * pipeline_.depth / bytes);
+    std::deque<Future<Coro<size_t>>> futs;
+    for (size_t g = 0; g < groups; ++g) {
+      while (futs.size() >= depth) {
+        co_await futs.front();
+        futs.pop_front();
+      }
+      auto off = g * bytes;
+      auto sz = std::min(bytes, len - off);
+      futs.emplace_back(Future(Write(src + off, sz, region.addr + off, region.key, (prefix << 16) | g)));
+    }
+    for (auto &fut : futs) co_await fut;
+    co_return len;
+  }
+
+  Coro<char *> Read(Oneway, uint64_t imm_data) {
+    if (imm_data == 0) throw std::invalid_argument("imm_data should be greater than 0");
+    co_return co_await remote_write_awaiter(this, imm_data);
+  }
+
+ private:
+  struct fid_ep *ep_ = nullptr;
+  fi_addr_t remote_;
+  size_t speed_ = 0;
+  size_t max_msg_size_ = 0;
+  std::chrono::nanoseconds rtt_{20000};  // initial guess, refined by Transfer
+  Pipeline pipeline_;
+  HostBuffer recv_buffer_;
+  HostBuffer send_buffer_;
+  CUDABuffer read_buffer_;
+  CUDABuffer write_buffer_;
+};
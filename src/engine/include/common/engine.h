@@ -0,0 +1,514 @@
+#pragma once
+
+#include <cuda_runtime.h>
+#include <spdlog/spdlog.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/conn.h"
+#include "common/cores.h"
+#include "common/coro.h"
+#include "common/future.h"
+#include "common/gpuloc.h"
+#include "common/io.h"
+#include "common/mpi.h"
+#include "common/net.h"
+#include "common/ring.h"
+#include "common/taskset.h"
+
+/** @brief Value type yielded by a coroutine type */
+template <typename C>
+struct CoroValue;
+
+template <typename T>
+struct CoroValue<Coro<T>> {
+  using type = T;
+};
+
+/**
+ * @brief Lock-free submission path from one application thread to a rail
+ *
+ * The application thread pushes transfer descriptors into a submission ring
+ * and the rail's loop pops them, posts the transfer and pushes a completion
+ * into the completion ring. Both rings are SPSC, so neither side takes a lock
+ * or allocates. At most Capacity() transfers are in flight, which guarantees
+ * the completion ring never overflows. Wait() sleeps on a futex (via
+ * std::atomic::wait) that the rail bumps after every completion, so a thread
+ * busy with computation does not have to spin on the loop to make progress.
+ */
+class Channel : private NoCopy {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  /** @brief Transfer descriptor */
+  struct Request {
+    uint64_t id;
+    int peer;
+    const char *src;
+    size_t len;
+    Region region;
+    uint64_t imm_data;
+    clock::time_point submitted;
+  };
+
+  /** @brief Completion of a Request */
+  struct Completion {
+    uint64_t id;
+    size_t len;                     ///< bytes written, 0 on failure
+    std::chrono::nanoseconds post;  ///< from Submit() until the first write was posted
+    bool ok;
+  };
+
+  /** @param capacity Transfers in flight, rounded up to a power of two */
+  explicit Channel(size_t capacity) : sq_{capacity}, cq_{capacity} {}
+
+  /** @brief Get the largest number of transfers in flight */
+  inline size_t Capacity() const noexcept { return sq_.Capacity(); }
+  /** @brief Get transfers submitted but not yet taken back (application thread) */
+  inline size_t GetInflight() const noexcept { return inflight_; }
+
+  /**
+   * @brief Queue a transfer, see Conn::Transfer (application thread)
+   * @param id Opaque id returned in the completion
+   * @return false if Capacity() transfers are already in flight
+   */
+  inline bool Submit(uint64_t id, int peer, const char *src, size_t len, const Region &region, uint64_t imm_data) noexcept {
+    if (inflight_ == Capacity()) return false;
+    if (!sq_.TryPush(Request{id, peer, src, len, region, imm_data, clock::now()})) return false;
+    ++inflight_;
+    return true;
+  }
+
+  /**
+   * @brief Take a completion without blocking (application thread)
+   * @return false if none is ready
+   */
+  inline bool Poll(Completion &completion) noexcept {
+    if (!cq_.TryPop(completion)) return false;
+    --inflight_;
+    return true;
+  }
+
+  /**
+   * @brief Block until a completion is ready (application thread)
+   * @throws std::logic_error if nothing is in flight
+   */
+  Completion Wait() {
+    if (inflight_ == 0) throw std::logic_error("Wait without a transfer in flight");
+    Completion completion;
+    for (;;) {
+      auto seq = done_.load(std::memory_order_acquire);
+      if (Poll(completion)) return completion;
+      done_.wait(seq, std::memory_order_acquire);
+    }
+  }
+
+ private:
+  friend class Rail;
+
+  /** @brief Publish a completion and wake a waiting thread (rail loop) */
+  inline void Complete(const Completion &completion) noexcept {
+    // cannot fail: the application never has more than Capacity() in flight
+    cq_.TryPush(completion);
+    done_.fetch_add(1, std::memory_order_release);
+    done_.notify_one();
+  }
+
+ private:
+  SpscRing<Request> sq_;
+  SpscRing<Completion> cq_;
+  std::atomic<uint32_t> done_{0};  // futex word bumped per completion
+  size_t inflight_ = 0;            // owned by the application thread
+};
+
+/**
+ * @brief One NIC driven by its own event loop thread
+ *
+ * The loop thread pins itself to a NIC-local physical core, selects the
+ * rail's GPU, opens the Net and then alternates between starting submitted
+ * work, polling the completion queue and running ready coroutines. The Net,
+ * its Conns and the thread's IO are only touched from that thread; other
+ * threads hand it work through Submit().
+ *
+ * A rail either owns its NIC's domain or opens its own endpoint and
+ * completion queue on the domain of another rail of the same NIC.
+ *
+ * Besides Submit(), which takes a lock and allocates per call, application
+ * threads can Attach() a Channel and hand the loop transfer descriptors
+ * through lock-free rings, turning the rail into a progress engine that owns
+ * all posting and polling.
+ */
+class Rail : private NoCopy {
+ public:
+  /**
+   * @brief Start the loop thread and wait until the endpoint is open
+   * @param index Rail index within the engine
+   * @param device CUDA device the rail's buffers are allocated on
+   * @param cpu OS index of the CPU the loop is pinned to
+   * @param efa Fabric info of the NIC
+   * @param threading Threading model of the domain (ignored with shared)
+   * @param shared Rail whose domain to share, or nullptr to open one
+   * @throws std::runtime_error if pinning, device selection or opening the endpoint fails
+   */
+  Rail(size_t index, int device, int cpu, struct fi_info *efa, enum fi_threading threading = FI_THREAD_DOMAIN, Rail *shared = nullptr)
+      : index_{index}, device_{device}, cpu_{cpu}, efa_{efa}, threading_{threading}, shared_{shared ? shared->net_.get() : nullptr} {
+    std::promise<void> ready;
+    auto opened = ready.get_future();
+    thread_ = std::thread([this, &ready] { Loop(ready); });
+    try {
+      opened.get();
+    } catch (...) {
+      thread_.join();
+      throw;
+    }
+  }
+
+  /** @brief Finish submitted work, close the endpoint and join the loop thread */
+  ~Rail() {
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) thread_.join();
+  }
+
+  /**
+   * @brief Run a coroutine on the rail's loop (thread-safe)
+   *
+   * fn is called on the loop thread with the rail and must return a Coro;
+   * it stays alive until that coroutine finished, so a capturing coroutine
+   * lambda is fine.
+   *
+   * @param fn Callable taking Rail & and returning Coro<T>
+   * @return Future receiving the coroutine's result or exception
+   */
+  template <typename F>
+  auto Submit(F &&fn) {
+    using T = typename CoroValue<std::invoke_result_t<F &, Rail &>>::type;
+    auto promise = std::make_shared<std::promise<T>>();
+    auto future = promise->get_future();
+    std::lock_guard lock(mu_);
+    inbox_.emplace_back([this, fn = std::forward<F>(fn), promise]() mutable { running_.emplace_back(Complete(std::move(fn), std::move(promise))); });
+    pending_.store(true, std::memory_order_release);
+    return future;
+  }
+
+  /**
+   * @brief Create a lock-free submission channel for the calling thread (thread-safe)
+   *
+   * The channel lives as long as the rail. Only one application thread may
+   * use it; give every thread its own.
+   *
+   * @param capacity Transfers in flight
+   * @return Channel polled by the rail's loop
+   */
+  Channel &Attach(size_t capacity) {
+    auto channel = std::make_unique<Channel>(capacity);
+    auto &ref = *channel;
+    auto owned = std::make_shared<std::unique_ptr<Channel>>(std::move(channel));
+    Submit([owned](Rail &rail) { return rail.Adopt(std::move(*owned)); }).get();
+    return ref;
+  }
+
+  /**
+   * @brief Connect to a peer's endpoint (loop thread only)
+   * @param peer Rank of the peer, used as the key of GetConn()
+   * @param remote Peer's endpoint address
+   * @return Coroutine yielding the connection
+   */
+  Coro<Conn *> Connect(int peer, std::string remote) {
+    auto conn = net_->Connect(remote.data());
+    conns_[peer] = conn;
+    co_return conn;
+  }
+
+  /**
+   * @brief Get the connection to a peer (loop thread, or after Connect() resolved)
+   * @throws std::out_of_range if the peer is not connected
+   */
+  inline Conn *GetConn(int peer) const { return conns_.at(peer); }
+
+  /** @brief Get the rail index */
+  inline size_t GetIndex() const noexcept { return index_; }
+  /** @brief Get the CUDA device of the rail's buffers */
+  inline int GetDevice() const noexcept { return device_; }
+  /** @brief Get the CPU the loop is pinned to */
+  inline int GetCPU() const noexcept { return cpu_; }
+  /** @brief Get the threading model of the rail's domain */
+  inline enum fi_threading GetThreading() const noexcept { return shared_ ? shared_->GetThreading() : threading_; }
+  /** @brief Check whether the rail shares another rail's domain */
+  inline bool IsShared() const noexcept { return !!shared_; }
+  /** @brief Get the fabric info of the NIC */
+  inline struct fi_info *GetInfo() const noexcept { return efa_; }
+  /** @brief Get the local endpoint address */
+  inline const char *GetAddr() const noexcept { return addr_; }
+
+ private:
+  void Loop(std::promise<void> &ready) {
+    try {
+      Taskset::SetThread(cpu_);
+      CUDA_CHECK(cudaSetDevice(device_));
+      net_ = std::make_unique<Net>();
+      if (shared_) {
+        net_->Open(*shared_);
+      } else {
+        net_->Open(efa_, threading_);
+      }
+      std::memcpy(addr_, net_->GetAddr(), kMaxAddrSize);
+    } catch (...) {
+      net_.reset();
+      ready.set_exception(std::current_exception());
+      return;
+    }
+    ready.set_value();
+
+    auto &io = IO::Get();
+    while (!stop_.load(std::memory_order_acquire) or pending_.load(std::memory_order_acquire) or !running_.empty()) {
+      if (pending_.load(std::memory_order_acquire)) Drain();
+      for (auto &channel : channels_) Serve(*channel);
+      io.Select();
+      io.Runone();
+      running_.remove_if([](auto &f) { return f.done(); });
+    }
+    conns_.clear();
+    net_.reset();
+  }
+
+  Coro<> Adopt(std::unique_ptr<Channel> channel) {
+    channels_.emplace_back(std::move(channel));
+    co_return;
+  }
+
+  inline void Serve(Channel &channel) {
+    Channel::Request request;
+    while (channel.sq_.TryPop(request)) running_.emplace_back(Execute(channel, request));
+  }
+
+  Coro<> Execute(Channel &channel, Channel::Request request) {
+    Channel::Completion completion{request.id, 0, {}, false};
+    try {
+      // Transfer starts eagerly, so its first segments are posted on return
+      auto transfer = GetConn(request.peer)->Transfer(request.src, request.len, request.region, request.imm_data);
+      completion.post = Channel::clock::now() - request.submitted;
+      completion.len = co_await std::move(transfer);
+      completion.ok = true;
+    } catch (const std::exception &e) {
+      SPDLOG_ERROR("rail {} transfer {} fail. error: {}", index_, request.id, e.what());
+    }
+    channel.Complete(completion);
+  }
+
+  inline void Drain() {
+    std::deque<std::function<void()>> tasks;
+    {
+      std::lock_guard lock(mu_);
+      tasks.swap(inbox_);
+      pending_.store(false, std::memory_order_relaxed);
+    }
+    for (auto &task : tasks) task();
+  }
+
+  template <typename F, typename T>
+  Coro<> Complete(F fn, std::shared_ptr<std::promise<T>> promise) {
+    try {
+      if constexpr (std::is_void_v<T>) {
+        co_await fn(*this);
+        promise->set_value();
+      } else {
+        promise->set_value(co_await fn(*this));
+      }
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  }
+
+ private:
+  size_t index_;
+  int device_;
+  int cpu_;
+  struct fi_info *efa_;
+  enum fi_threading threading_;
+  Net *shared_;  // owned by a rail constructed earlier; ~Engine destroys it later
+  char addr_[kMaxAddrSize] = {0};
+  std::thread thread_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> pending_{false};  // inbox_ is not empty
+  std::mutex mu_;
+  std::deque<std::function<void()>> inbox_;
+  // owned by the loop thread
+  std::unique_ptr<Net> net_;
+  std::unordered_map<int, Conn *> conns_;
+  std::list<Future<Coro<>>> running_;
+  std::vector<std::unique_ptr<Channel>> channels_;
+};
+
+/**
+ * @brief Single-process engine driving every NIC of the host
+ *
+ * Instead of one rank per GPU, one process owns all devices. The engine
+ * opens one Rail per NIC found by GPUloc; its buffers live on the first GPU
+ * sharing the NIC's PCIe switch and its loop runs on a NIC-local core, IRQ-free
+ * ones first, with no two rails on the same physical core. Any thread may
+ * submit work: Transfer() routes a write to the rail whose buffer holds the
+ * source, so a payload always leaves through the NIC next to its memory.
+ *
+ * Threading models:
+ * - FI_THREAD_DOMAIN (default): one loop per NIC owns the whole domain, so
+ *   the provider posts and polls without locks.
+ * - FI_THREAD_COMPLETION: several workers per NIC, each with its own
+ *   endpoint and completion queue over one shared domain. Each worker's
+ *   connections still register their own buffers with that domain.
+ * - FI_THREAD_SAFE: the provider locks every call, as the other examples do.
+ */
+class Engine : private NoCopy {
+ public:
+  /**
+   * @brief Start workers rails per NIC
+   * @param threading Threading model of every domain
+   * @param workers Rails per NIC; more than one shares the NIC's domain
+   * @throws std::invalid_argument if workers share a domain opened with FI_THREAD_DOMAIN
+   * @throws std::runtime_error if there is no NIC or not enough NIC-local cores
+   */
+  explicit Engine(enum fi_threading threading = FI_THREAD_DOMAIN, size_t workers = 1) {
+    if (workers < 1) throw std::invalid_argument("engine needs at least one worker per NIC");
+    if (workers > 1 and threading == FI_THREAD_DOMAIN) throw std::invalid_argument("workers sharing a domain need FI_THREAD_COMPLETION or FI_THREAD_SAFE");
+    auto &affinities = GPUloc::Get().GetGPUAffinity();
+    std::set<struct fi_info *> seen;
+    std::set<int> used;
+    try {
+      for (size_t gpu = 0; gpu < affinities.size(); ++gpu) {
+        auto &affinity = affinities[gpu];
+        for (auto &[efa_obj, efa] : affinity.efas) {
+          // GPUs behind the same switch share the NIC's fi_info
+          if (!seen.insert(efa).second) continue;
+          auto cores = CoreAllocator(affinity.cores, {efa_obj});
+          auto &owner = rails_.emplace_back(std::make_unique<Rail>(rails_.size(), gpu, Pick(cores, used), efa, threading));
+          for (size_t w = 1; w < workers; ++w) rails_.emplace_back(std::make_unique<Rail>(rails_.size(), gpu, Pick(cores, used), efa, threading, owner.get()));
+        }
+      }
+    } catch (...) {
+      // the destructor does not run for a partly built engine
+      Stop();
+      throw;
+    }
+    if (rails_.empty()) throw std::runtime_error("no EFA device next to any GPU");
+  }
+
+  /** @brief Stop the rails, see Stop() */
+  ~Engine() { Stop(); }
+
+  /** @brief Get the number of rails */
+  inline size_t Size() const noexcept { return rails_.size(); }
+  /** @brief Get a rail by index */
+  inline Rail &operator[](size_t i) const noexcept { return *rails_[i]; }
+
+  /**
+   * @brief Connect every rail to the rail with the same index in a peer process
+   *
+   * Collective over MPI_COMM_WORLD; every process must have the same number
+   * of rails. Call it before submitting work to the connections.
+   *
+   * @param peer Rank of the peer process
+   * @throws std::runtime_error if the processes have different numbers of rails
+   */
+  void Connect(int peer) {
+    auto &mpi = MPI::Get();
+    int rails = rails_.size(), min = 0, max = 0;
+    MPI_Allreduce(&rails, &min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&rails, &max, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (min != max) throw std::runtime_error(fmt::format("rails differ across processes: min={} max={}", min, max));
+
+    auto stride = rails * kMaxAddrSize;
+    std::string endpoints(mpi.GetWorldSize() * stride, 0);
+    auto local = endpoints.data() + mpi.GetWorldRank() * stride;
+    for (int i = 0; i < rails; ++i) std::memcpy(local + i * kMaxAddrSize, rails_[i]->GetAddr(), kMaxAddrSize);
+    MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, endpoints.data(), stride, MPI_BYTE, MPI_COMM_WORLD);
+
+    std::vector<std::future<Conn *>> futs;
+    for (int i = 0; i < rails; ++i) {
+      std::string remote(endpoints.data() + peer * stride + i * kMaxAddrSize, kMaxAddrSize);
+      futs.emplace_back(rails_[i]->Submit([peer, remote](Rail &rail) { return rail.Connect(peer, remote); }));
+    }
+    std::unique_lock lock(mu_);
+    for (int i = 0; i < rails; ++i) {
+      auto conn = futs[i].get();
+      auto &write = conn->GetWriteBuffer();
+      auto &read = conn->GetReadBuffer();
+      buffers_[(uintptr_t)write.GetData()] = {write.GetSize(), rails_[i].get()};
+      buffers_[(uintptr_t)read.GetData()] = {read.GetSize(), rails_[i].get()};
+    }
+  }
+
+  /**
+   * @brief Find the rail whose registered buffer contains ptr (thread-safe)
+   * @throws std::invalid_argument if no rail registered the memory
+   */
+  Rail &Route(const void *ptr) const {
+    std::shared_lock lock(mu_);
+    auto addr = (uintptr_t)ptr;
+    auto it = buffers_.upper_bound(addr);
+    if (it != buffers_.begin()) {
+      --it;
+      auto &[size, rail] = it->second;
+      if (addr < it->first + size) return *rail;
+    }
+    throw std::invalid_argument("buffer is not registered with any rail");
+  }
+
+  /**
+   * @brief Write a payload to a peer through the rail owning the source (thread-safe)
+   * @param peer Rank of the peer process
+   * @param src Payload inside a rail's write buffer
+   * @param len Payload size in bytes
+   * @param region Destination region
+   * @param imm_data Completion immediate data, see Conn::Transfer
+   * @return Future yielding bytes written
+   */
+  std::future<size_t> Transfer(int peer, const char *src, size_t len, const Region &region, uint64_t imm_data) {
+    return Route(src).Submit([=](Rail &rail) { return rail.GetConn(peer)->Transfer(src, len, region, imm_data); });
+  }
+
+ private:
+  inline static int Pick(const CoreAllocator &cores, std::set<int> &used) {
+    // GetCores() lists cores without the NIC's interrupts first
+    for (auto &core : cores.GetCores()) {
+      auto cpu = core.pus.front();
+      if (!used.insert(cpu).second) continue;
+      if (core.irq) SPDLOG_WARN("rail loop shares core with NIC interrupts (cpu {})", cpu);
+      return cpu;
+    }
+    throw std::runtime_error("no free NIC-local core for a rail");
+  }
+
+  /**
+   * @brief Stop the rails in reverse order
+   *
+   * A worker rail has its endpoint, completion queues and memory regions open
+   * on the domain of the owner rail created before it, so it must be closed
+   * before the owner closes that domain and fabric.
+   */
+  void Stop() noexcept {
+    while (!rails_.empty()) rails_.pop_back();
+  }
+
+ private:
+  std::vector<std::unique_ptr<Rail>> rails_;
+  mutable std::shared_mutex mu_;
+  std::map<uintptr_t, std::pair<size_t, Rail *>> buffers_;  // base address -> (size, rail)
+};
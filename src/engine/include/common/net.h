@@ -0,0 +1,147 @@
+#pragma once
+#include <rdma/fabric.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "common/conn.h"
+#include "common/io.h"
+#include "common/utils.h"
+
+/**
+ * @brief Network abstraction for EFA fabric operations
+ *
+ * Transmit and receive completions go to separate completion queues. The
+ * receive queue, which also reports remote writes carrying immediate data,
+ * is polled first and drained completely. The transmit queue yields after a
+ * budget, so a burst of bulk write completions cannot delay a small message.
+ */
+class Net {
+ public:
+  /** @brief Default polling of the receive queue */
+  inline constexpr static Polling kRxPolling{Polling::kUnlimited, 1};
+  /** @brief Default polling of the transmit queue */
+  inline constexpr static Polling kTxPolling{4 * kMaxCQEntries, 0};
+
+  Net() = default;
+  ~Net();
+
+  /**
+   * @brief Initialize network with fabric info
+   *
+   * The domain is opened with the given threading model instead of the one
+   * the info was discovered with: FI_THREAD_DOMAIN lets the provider skip its
+   * locks when a single thread drives the whole domain.
+   *
+   * @param info Fabric information structure
+   * @param threading FI_THREAD_SAFE, FI_THREAD_DOMAIN or FI_THREAD_COMPLETION
+   * @throws std::runtime_error on fabric initialization failure
+   */
+  void Open(struct fi_info *info, enum fi_threading threading = FI_THREAD_SAFE);
+
+  /**
+   * @brief Open another endpoint and completion queue on a shared domain
+   *
+   * Memory registered with the shared domain is usable from this endpoint.
+   * With FI_THREAD_COMPLETION every thread can own one such Net without the
+   * provider locking the endpoint or the completion queue.
+   *
+   * @param shared Net owning the fabric and domain; must outlive this one
+   * @throws std::runtime_error on endpoint initialization failure
+   */
+  void Open(Net &shared);
+
+  /**
+   * @brief Establish connection to remote endpoint
+   * @param remote Remote endpoint address string
+   * @return Pointer to connection object
+   * @throws std::runtime_error on connection failure
+   */
+  Conn *Connect(const char *remote);
+
+  /**
+   * @brief Get local endpoint address
+   * @return Local address buffer
+   */
+  const char *GetAddr() { return addr_; }
+
+  /** @brief Get the transmit completion queue (sends and local write completions) */
+  struct fid_cq *GetTxCQ() { return tx_cq_; }
+  /** @brief Get the receive completion queue (receives and remote writes with immediate data) */
+  struct fid_cq *GetRxCQ() { return rx_cq_; }
+
+  /**
+   * @brief Set how the selector polls each queue; takes effect on Open()
+   * @param rx Budget and priority of the receive queue
+   * @param tx Budget and priority of the transmit queue
+   */
+  void SetPolling(Polling rx, Polling tx) noexcept {
+    rx_polling_ = rx;
+    tx_polling_ = tx;
+  }
+
+  /** @brief Get the threading model the domain was opened with */
+  enum fi_threading GetThreading() const noexcept { return info_ ? info_->domain_attr->threading : FI_THREAD_UNSPEC; }
+
+  /**
+   * @brief Convert binary address to hex string
+   * @param addr Binary address buffer
+   * @return Hex string representation
+   */
+  inline static std::string Addr2Str(const char *addr) {
+    std::string out;
+    for (size_t i = 0; i < kAddrSize; ++i) out += fmt::format("{:02x}", addr[i]);
+    return out;
+  }
+
+  /**
+   * @brief Convert hex string to binary address
+   * @param addr Hex string address
+   * @param bytes Output binary buffer
+   */
+  inline static void Str2Addr(const std::string &addr, char *bytes) {
+    for (size_t i = 0; i < kAddrSize; ++i) sscanf(addr.c_str() + 2 * i, "%02hhx", &bytes[i]);
+  }
+
+ private:
+  void OpenEndpoint();
+
+  inline void Register() {
+    auto &io = IO::Get();
+    if (rx_cq_) io.Register(rx_cq_, rx_polling_);
+    if (tx_cq_) io.Register(tx_cq_, tx_polling_);
+  }
+
+  inline void UnRegister() {
+    auto &io = IO::Get();
+    if (rx_cq_) io.UnRegister(rx_cq_);
+    if (tx_cq_) io.UnRegister(tx_cq_);
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const Net &net) {
+    os << "device addr:\n" << "  " << Addr2Str(net.addr_) << "\n";
+    os << "remote addr:\n";
+    for (auto &c : net.conns_) os << "  " << c.first << "\n";
+    return os;
+  }
+
+ private:
+  struct fid_fabric *fabric_ = nullptr;
+  struct fid_domain *domain_ = nullptr;
+  struct fid_ep *ep_ = nullptr;
+  struct fid_cq *tx_cq_ = nullptr;
+  struct fid_cq *rx_cq_ = nullptr;
+  Polling rx_polling_ = kRxPolling;
+  Polling tx_polling_ = kTxPolling;
+  struct fid_av *av_ = nullptr;
+  struct fi_info *info_ = nullptr;  // owned copy with the chosen threading model
+  bool shared_ = false;             // fabric and domain belong to another Net
+  char addr_[kMaxAddrSize] = {0};
+  std::unordered_map<std::string, std::unique_ptr<Conn>> conns_;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+#include "common/utils.h"
+
+/**
+ * @brief Bounded single-producer single-consumer ring
+ *
+ * One thread pushes and one other thread pops. Each side only stores its own
+ * index, so neither needs a lock: the producer publishes a slot with a
+ * release store of tail, the consumer frees it with a release store of head.
+ * The indices live on separate cache lines and each side keeps a cached copy
+ * of the other's index, touching the shared line only when the ring looks
+ * full or empty.
+ */
+template <typename T>
+class SpscRing : private NoCopy {
+ public:
+  /** @brief Assumed cache line size, kept constant so the layout does not depend on -mtune */
+  inline constexpr static size_t kCacheLine = 64;
+
+  /**
+   * @brief Allocate the ring
+   * @param capacity Minimum number of slots, rounded up to a power of two
+   */
+  explicit SpscRing(size_t capacity) : mask_{std::bit_ceil(std::max<size_t>(capacity, 1)) - 1}, slots_(mask_ + 1) {}
+
+  /** @brief Get the number of slots */
+  inline size_t Capacity() const noexcept { return mask_ + 1; }
+
+  /**
+   * @brief Append an item (producer only)
+   * @return false if the ring is full
+   */
+  inline bool TryPush(const T &item) noexcept {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) return false;
+    }
+    slots_[tail & mask_] = item;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Take the oldest item (consumer only)
+   * @return false if the ring is empty
+   */
+  inline bool TryPop(T &item) noexcept {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    item = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  size_t mask_;
+  std::vector<T> slots_;
+  alignas(kCacheLine) std::atomic<size_t> head_{0};  // written by the consumer
+  size_t tail_cache_ = 0;                            // consumer's view of tail_
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};  // written by the producer
+  size_t head_cache_ = 0;                            // producer's view of head_
+};
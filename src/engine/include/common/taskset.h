@@ -0,0 +1,84 @@
+#pragma once
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <vector>
+
+#define TASKSET_CHECK(exp)                                              \
+  do {                                                                  \
+    auto rc = (exp);                                                    \
+    if (rc < 0) {                                                       \
+      auto msg = fmt::format(#exp " fail. error: {}", strerror(errno)); \
+      SPDLOG_ERROR(msg);                                                \
+      throw std::runtime_error(msg);                                    \
+    }                                                                   \
+  } while (0)
+
+struct Taskset {
+  /**
+   * @brief Bind current process to a specific CPU core
+   * @param cpu CPU core ID to bind to
+   * @throws std::runtime_error if sched_setaffinity fails
+   */
+  inline static void Set(int cpu) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);  // Bind process to 'cpu'
+
+    pid_t pid = getpid();
+    TASKSET_CHECK(sched_setaffinity(pid, sizeof(mask), &mask));
+  }
+
+  /**
+   * @brief Bind current process to multiple CPU cores
+   * @param cpus Vector of CPU core IDs to bind to
+   * @throws std::runtime_error if sched_setaffinity fails
+   */
+  inline static void Set(std::vector<int> cpus) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (auto cpu : cpus) CPU_SET(cpu, &mask);
+
+    pid_t pid = getpid();
+    TASKSET_CHECK(sched_setaffinity(pid, sizeof(mask), &mask));
+  }
+
+  /**
+   * @brief Get the CPUs the current process may run on, e.g. as bound by the launcher
+   * @return OS indices of the CPUs in ascending order
+   * @throws std::runtime_error if sched_getaffinity fails
+   */
+  inline static std::vector<int> Get() {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    TASKSET_CHECK(sched_getaffinity(getpid(), sizeof(mask), &mask));
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) cpus.emplace_back(cpu);
+    }
+    return cpus;
+  }
+
+  /**
+   * @brief Bind a single thread to a specific CPU, leaving the rest of the process unpinned
+   * @param cpu OS index of the CPU
+   * @param thread Thread to bind, the calling thread by default
+   * @throws std::runtime_error if pthread_setaffinity_np fails
+   */
+  inline static void SetThread(int cpu, pthread_t thread = pthread_self()) {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    // pthread functions return the error number instead of setting errno
+    auto rc = pthread_setaffinity_np(thread, sizeof(mask), &mask);
+    if (rc) {
+      auto msg = fmt::format("pthread_setaffinity_np fail. error: {}", strerror(rc));
+      SPDLOG_ERROR(msg);
+      throw std::runtime_error(msg);
+    }
+  }
+};
@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/engine.h"
+#include "common/mpi.h"
+#include "common/pairing.h"
+#include "common/progress.h"
+
+constexpr uint32_t kImmData = 0x123;
+constexpr size_t kDepth = 2;        // transfers each submitting thread keeps in flight per rail
+constexpr size_t kPostSize = 64;    // bytes per message of the post benchmark
+constexpr size_t kPostWindow = 64;  // messages in flight per rail in the post benchmark
+constexpr size_t kChunk = 8 << 20;  // bytes per transfer of the progress benchmark
+constexpr size_t kChannel = 4;      // transfers in flight per channel in the progress benchmark
+
+/**
+ * @brief Threading model benchmarked by the post mode
+ */
+struct Model {
+  const char *name;
+  enum fi_threading threading;
+  bool workers;  ///< whether the model runs the requested workers per NIC or one
+};
+
+constexpr Model kModels[] = {
+    {"safe", FI_THREAD_SAFE, false},
+    {"domain", FI_THREAD_DOMAIN, false},
+    {"safe", FI_THREAD_SAFE, true},
+    {"completion", FI_THREAD_COMPLETION, true},
+};
+
+/**
+ * @brief Posting cost and message rate of one rail
+ */
+struct PostStats {
+  std::chrono::nanoseconds post{0};   ///< time spent issuing writes
+  std::chrono::nanoseconds total{0};  ///< time until the last write completed
+};
+
+/**
+ * @brief Advertise every rail's read buffer to the writer
+ */
+void Advertise(Engine &engine, int peer) {
+  std::vector<std::future<size_t>> futs;
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    futs.emplace_back(engine[i].Submit([peer](Rail &rail) {
+      auto conn = rail.GetConn(peer);
+      auto &buffer = conn->GetReadBuffer();
+      Region region{(uint64_t)buffer.GetData(), buffer.GetSize(), buffer.GetMR()->key};
+      return conn->Send((const char *)&region, sizeof(region));
+    }));
+  }
+  for (auto &f : futs) ASSERT(f.get() == sizeof(Region));
+}
+
+/**
+ * @brief Receive the region the peer advertised on every rail
+ */
+std::vector<Region> Discover(Engine &engine, int peer) {
+  std::vector<std::future<Region>> futs;
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    futs.emplace_back(engine[i].Submit([peer](Rail &rail) -> Coro<Region> {
+      auto [buf, size] = co_await rail.GetConn(peer)->Recv();
+      ASSERT(size == sizeof(Region));
+      co_return *(Region *)buf;
+    }));
+  }
+  std::vector<Region> regions;
+  for (auto &f : futs) regions.emplace_back(f.get());
+  return regions;
+}
+
+/**
+ * @brief Write repeat rounds through every rail at once
+ *
+ * One application thread per rail submits Engine::Transfer calls, which the
+ * engine routes to the rail owning the source buffer.
+ */
+void Write(Engine &engine, int peer, size_t size, size_t repeat) {
+  auto regions = Discover(engine, peer);
+  std::vector<std::future<double>> bws;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    bws.emplace_back(std::async(std::launch::async, [&, i] {
+      auto src = (const char *)engine[i].GetConn(peer)->GetWriteBuffer().GetData();
+      auto begin = std::chrono::steady_clock::now();
+      std::deque<std::future<size_t>> futs;
+      for (size_t r = 0; r < repeat; ++r) {
+        while (futs.size() >= kDepth) {
+          futs.front().get();
+          futs.pop_front();
+        }
+        futs.emplace_back(engine.Transfer(peer, src, size, regions[i], kImmData));
+      }
+      for (auto &f : futs) f.get();
+      auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+      return size * repeat * Progress::Gb / elapse;
+    }));
+  }
+
+  double sum = 0;
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    auto bw = bws[i].get();
+    auto &rail = engine[i];
+    sum += bw;
+    std::cout << fmt::format("rail={} gpu={} cpu={} efa={} bw={:.3f}Gbps", i, rail.GetDevice(), rail.GetCPU(), rail.GetInfo()->domain_attr->name, bw)
+              << std::endl;
+  }
+  auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << fmt::format("rails={} sum={:.3f}Gbps aggregate={:.3f}Gbps", engine.Size(), sum, size * repeat * engine.Size() * Progress::Gb / elapse)
+            << std::endl;
+}
+
+/**
+ * @brief Wait for repeat rounds on every rail
+ */
+void Read(Engine &engine, int peer, size_t repeat) {
+  Advertise(engine, peer);
+  std::vector<std::future<void>> futs;
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    futs.emplace_back(engine[i].Submit([peer, repeat](Rail &rail) -> Coro<> {
+      auto conn = rail.GetConn(peer);
+      for (size_t r = 0; r < repeat; ++r) co_await conn->Read(kImmData);
+    }));
+  }
+  for (auto &f : futs) f.get();
+}
+
+/**
+ * @brief Issue small writes back to back, timing only the posting path
+ *
+ * Conn::Write starts eagerly, so creating its Future covers the coroutine
+ * frame and fi_writemsg, including whatever locking the threading model of
+ * the domain makes the provider take.
+ */
+Coro<PostStats> Post(Conn *conn, Region region, size_t msgs) {
+  using clock = std::chrono::steady_clock;
+  auto src = (const char *)conn->GetWriteBuffer().GetData();
+  std::deque<Future<Coro<size_t>>> futs;
+  PostStats stats;
+  auto start = clock::now();
+  for (size_t i = 0; i < msgs; ++i) {
+    while (futs.size() >= kPostWindow) {
+      co_await futs.front();
+      futs.pop_front();
+    }
+    auto issue = clock::now();
+    futs.emplace_back(Future(conn->Write(src, kPostSize, region.addr, region.key)));
+    stats.post += clock::now() - issue;
+  }
+  for (auto &f : futs) co_await f;
+  stats.total = clock::now() - start;
+  co_return stats;
+}
+
+/**
+ * @brief Compare posting cost and message rate across threading models
+ * @param peer Rank of the peer process
+ * @param writer Whether this process posts
+ * @param workers Workers per NIC for the multi-threaded models
+ * @param msgs Messages per rail
+ */
+void PostModels(int peer, bool writer, size_t workers, size_t msgs) {
+  if (writer) {
+    std::cout << fmt::format("# size={} window={} msgs={}", kPostSize, kPostWindow, msgs) << std::endl;
+    std::cout << fmt::format("{:>12} {:>8} {:>6} {:>10} {:>12}", "model", "workers", "rails", "post(ns)", "rate(Mmsg/s)") << std::endl;
+  }
+  for (auto &model : kModels) {
+    auto engine = Engine(model.threading, model.workers ? workers : 1);
+    engine.Connect(peer);
+    if (writer) {
+      auto regions = Discover(engine, peer);
+      std::vector<std::future<PostStats>> futs;
+      for (size_t i = 0; i < engine.Size(); ++i) {
+        futs.emplace_back(engine[i].Submit([peer, msgs, region = regions[i]](Rail &rail) { return Post(rail.GetConn(peer), region, msgs); }));
+      }
+      std::chrono::nanoseconds post{0}, longest{0};
+      for (auto &f : futs) {
+        auto stats = f.get();
+        post += stats.post;
+        longest = std::max(longest, stats.total);
+      }
+      auto rails = engine.Size();
+      std::cout << fmt::format("{:>12} {:>8} {:>6} {:>10.1f} {:>12.3f}", model.name, model.workers ? workers : 1, rails,
+                               (double)post.count() / (rails * msgs), rails * msgs * 1e3 / longest.count())
+                << std::endl;
+    } else {
+      Advertise(engine, peer);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+}
+
+/**
+ * @brief Keep the calling thread busy with arithmetic, standing in for tensor pre- and post-processing
+ * @param us Duration in microseconds
+ * @return Result, so the work cannot be optimized away
+ */
+double Compute(size_t us) {
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  double x = 1.0;
+  while (std::chrono::steady_clock::now() < end) {
+    for (int i = 0; i < 1024; ++i) x = x * 1.0000001 + 1e-9;
+  }
+  return x;
+}
+
+/**
+ * @brief Submit transfers through per-thread channels while computing in between
+ *
+ * One application thread per rail attaches a Channel and loops: submit until
+ * the channel is full, compute for compute_us, then reap completions, blocking
+ * on the channel's futex only when nothing could be submitted. The rails
+ * post and poll on their own, so throughput should not depend on compute_us.
+ * Reports the submission-to-post latency of every transfer and the bandwidth.
+ */
+void WriteChannels(Engine &engine, int peer, size_t compute_us, size_t rounds) {
+  struct Result {
+    std::vector<std::chrono::nanoseconds> post;
+    double bw;
+  };
+  auto regions = Discover(engine, peer);
+  std::vector<std::future<Result>> results;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    results.emplace_back(std::async(std::launch::async, [&, i] {
+      auto &rail = engine[i];
+      auto &channel = rail.Attach(kChannel);
+      auto src = (const char *)rail.GetConn(peer)->GetWriteBuffer().GetData();
+      Result result;
+      result.post.reserve(rounds);
+      volatile double sink = 0;
+      size_t submitted = 0;
+      auto begin = std::chrono::steady_clock::now();
+      auto reap = [&](const Channel::Completion &c) {
+        ASSERT(c.ok);
+        result.post.emplace_back(c.post);
+      };
+      while (result.post.size() < rounds) {
+        bool progressed = false;
+        while (submitted < rounds and channel.Submit(submitted, peer, src, kChunk, regions[i], kImmData)) {
+          ++submitted;
+          progressed = true;
+        }
+        if (compute_us) sink = sink + Compute(compute_us);
+        Channel::Completion c;
+        while (channel.Poll(c)) {
+          reap(c);
+          progressed = true;
+        }
+        if (!progressed and channel.GetInflight()) reap(channel.Wait());
+      }
+      auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+      result.bw = kChunk * rounds * Progress::Gb / elapse;
+      return result;
+    }));
+  }
+
+  std::cout << fmt::format("# chunk={} channel={} rounds={} compute={}us", kChunk, kChannel, rounds, compute_us) << std::endl;
+  std::cout << fmt::format("{:>6} {:>10} {:>10} {:>10} {:>12}", "rail", "p50(us)", "p99(us)", "max(us)", "bw(Gbps)") << std::endl;
+  double sum = 0;
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    auto result = results[i].get();
+    auto &post = result.post;
+    std::sort(post.begin(), post.end());
+    auto at = [&](double q) { return post[std::min(post.size() - 1, (size_t)(q * post.size()))].count() / 1e3; };
+    sum += result.bw;
+    std::cout << fmt::format("{:>6} {:>10.2f} {:>10.2f} {:>10.2f} {:>12.3f}", i, at(0.5), at(0.99), post.back().count() / 1e3, result.bw) << std::endl;
+  }
+  auto elapse = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << fmt::format("rails={} sum={:.3f}Gbps aggregate={:.3f}Gbps", engine.Size(), sum, kChunk * rounds * engine.Size() * Progress::Gb / elapse)
+            << std::endl;
+}
+
+/**
+ * @brief Keep chunk writes going until stop is set
+ *
+ * Chunks are split like Conn::Transfer splits them, but no write carries an
+ * immediate: nobody on the peer consumes them, and each one would stay parked
+ * in its selector as an early completion.
+ */
+Coro<> Bulk(Conn *conn, Region region, const bool &stop) {
+  auto src = (const char *)conn->GetWriteBuffer().GetData();
+  std::deque<Future<Coro<size_t>>> writes;
+  while (!stop) {
+    auto [segment, depth] = conn->GetPipeline();
+    for (size_t off = 0; off < kChunk; off += segment) {
+      if (writes.size() >= depth) {
+        co_await writes.front();
+        writes.pop_front();
+      }
+      writes.emplace_back(Future(conn->Write(src + off, std::min(segment, kChunk - off), region.addr + off, region.key)));
+    }
+  }
+  for (auto &w : writes) co_await w;
+}
+
+/**
+ * @brief Measure 8-byte SEND/RECV round trips; the receive is posted before the ping goes out
+ */
+Coro<std::vector<std::chrono::nanoseconds>> Ping(Conn *conn, size_t pings) {
+  using clock = std::chrono::steady_clock;
+  std::vector<std::chrono::nanoseconds> rtts;
+  rtts.reserve(pings);
+  for (uint64_t i = 0; i < pings; ++i) {
+    auto start = clock::now();
+    auto pong = Future(conn->Recv());
+    co_await conn->Send((const char *)&i, sizeof(i));
+    co_await pong;
+    rtts.emplace_back(clock::now() - start);
+  }
+  co_return rtts;
+}
+
+/**
+ * @brief Echo pings back, keeping the next receive posted while replying
+ */
+Coro<> Pong(Conn *conn, size_t pings) {
+  std::deque<Future<Coro<std::pair<char *, size_t>>>> recvs;
+  recvs.emplace_back(Future(conn->Recv()));
+  for (size_t i = 0; i < pings; ++i) {
+    auto [buf, size] = co_await recvs.front();
+    uint64_t seq;
+    std::memcpy(&seq, buf, sizeof(seq));
+    recvs.pop_front();
+    if (i + 1 < pings) recvs.emplace_back(Future(conn->Recv()));
+    co_await conn->Send((const char *)&seq, sizeof(seq));
+  }
+}
+
+/**
+ * @brief Small-message latency on rail 0, idle or under depth concurrent bulk transfers
+ *
+ * The bulk writes carry no immediate, so the reader only consumes the pings.
+ */
+void Latency(Engine &engine, int peer, bool writer, size_t depth, size_t pings) {
+  if (!writer) {
+    Advertise(engine, peer);
+    engine[0].Submit([peer, pings](Rail &rail) { return Pong(rail.GetConn(peer), pings); }).get();
+    return;
+  }
+  auto regions = Discover(engine, peer);
+  auto rtts = engine[0]
+                  .Submit([peer, depth, pings, region = regions[0]](Rail &rail) -> Coro<std::vector<std::chrono::nanoseconds>> {
+                    auto conn = rail.GetConn(peer);
+                    bool stop = false;
+                    std::deque<Future<Coro<>>> bulk;
+                    for (size_t d = 0; d < depth; ++d) bulk.emplace_back(Future(Bulk(conn, region, stop)));
+                    auto rtts = co_await Ping(conn, pings);
+                    stop = true;
+                    for (auto &b : bulk) co_await b;
+                    co_return rtts;
+                  })
+                  .get();
+  std::sort(rtts.begin(), rtts.end());
+  auto at = [&](double q) { return rtts[std::min(rtts.size() - 1, (size_t)(q * rtts.size()))].count() / 1e3; };
+  auto &rail = engine[0];
+  std::cout << fmt::format("rail=0 efa={} bulk={}x{} pings={} p50={:.2f}us p99={:.2f}us max={:.2f}us", rail.GetInfo()->domain_attr->name, depth, kChunk,
+                           pings, at(0.5), at(0.99), rtts.back().count() / 1e3)
+            << std::endl;
+}
+
+/**
+ * usage: engine [transfer [repeat] | post [workers] [msgs] | progress [compute_us] [rounds] | latency [depth] [pings]]
+ *
+ * One process per node drives every NIC of the node through an Engine.
+ * transfer (default): the writer's process writes repeat rounds on all rails
+ * concurrently and prints every rail's bandwidth and the aggregate.
+ * post: 64-byte writes under FI_THREAD_SAFE and FI_THREAD_DOMAIN with one
+ * loop per NIC, then FI_THREAD_SAFE and FI_THREAD_COMPLETION with workers
+ * loops per NIC sharing its domain; reports the average cost of posting a
+ * write and the aggregate message rate.
+ * progress: application threads submit 8 MiB transfers through lock-free
+ * channels and compute for compute_us between submissions; reports the
+ * submission-to-post latency and the bandwidth.
+ * latency: 8-byte ping-pong round trips on rail 0 while depth 8 MiB
+ * writes keep the same endpoint busy (0 for idle).
+ */
+int main(int argc, char *argv[]) {
+  constexpr size_t page_size = 256 << 10;  // 256k
+  constexpr size_t num_pages = 250;
+  std::string mode = argc > 1 ? argv[1] : "transfer";
+  auto pair = Pairing::Get("node");
+  auto &mpi = MPI::Get();
+  if (mode == "post") {
+    size_t workers = argc > 2 ? std::stoul(argv[2]) : 2;
+    size_t msgs = argc > 3 ? std::stoul(argv[3]) : 1000000;
+    PostModels(pair.peer, pair.role == Pairing::kWriter, workers, msgs);
+    return 0;
+  }
+  if (mode == "progress") {
+    size_t compute_us = argc > 2 ? std::stoul(argv[2]) : 0;
+    size_t rounds = argc > 3 ? std::stoul(argv[3]) : 1000;
+    auto engine = Engine();
+    engine.Connect(pair.peer);
+    if (pair.role == Pairing::kWriter) {
+      WriteChannels(engine, pair.peer, compute_us, rounds);
+    } else {
+      Read(engine, pair.peer, rounds);
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    return 0;
+  }
+  if (mode == "latency") {
+    size_t depth = argc > 2 ? std::stoul(argv[2]) : 0;
+    size_t pings = argc > 3 ? std::stoul(argv[3]) : 10000;
+    auto engine = Engine();
+    engine.Connect(pair.peer);
+    Latency(engine, pair.peer, pair.role == Pairing::kWriter, depth, pings);
+    MPI_Barrier(MPI_COMM_WORLD);
+    return 0;
+  }
+  if (mode != "transfer") throw std::invalid_argument(fmt::format("unknown mode {}", mode));
+
+  size_t repeat = argc > 2 ? std::stoul(argv[2]) : 1000;
+  auto engine = Engine();
+  for (size_t i = 0; i < engine.Size(); ++i) {
+    auto &rail = engine[i];
+    std::cout << fmt::format("[RANK:{}] RAIL({}) GPU({}) CPU({}) EFA({}) PEER({})", mpi.GetWorldRank(), i, rail.GetDevice(), rail.GetCPU(),
+                             rail.GetInfo()->domain_attr->name, pair.peer)
+              << std::endl;
+  }
+  engine.Connect(pair.peer);
+  if (pair.role == Pairing::kWriter) {
+    Write(engine, pair.peer, page_size * num_pages, repeat);
+  } else {
+    Read(engine, pair.peer, repeat);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
+}
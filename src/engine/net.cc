@@ -0,0 +1,75 @@
+#include "common/net.h"
+
+Conn *Net::Connect(const char *remote) {
+  fi_addr_t addr = FI_ADDR_UNSPEC;
+  EXPECT(fi_av_insert(av_, remote, 1, &addr, 0, nullptr), 1);
+  auto key = Addr2Str(remote);
+  auto conn = std::make_unique<Conn>(ep_, domain_, addr, info_);
+  auto raw_conn = conn.get();
+  conns_.emplace(key, std::move(conn));
+  return raw_conn;
+}
+
+void Net::Open(struct fi_info *info, enum fi_threading threading) {
+  info_ = fi_dupinfo(info);
+  ASSERT(!!info_);
+  info_->domain_attr->threading = threading;
+  CHECK(fi_fabric(info_->fabric_attr, &fabric_, nullptr));
+  CHECK(fi_domain(fabric_, info_, &domain_, nullptr));
+  OpenEndpoint();
+}
+
+void Net::Open(Net &shared) {
+  info_ = fi_dupinfo(shared.info_);
+  ASSERT(!!info_);
+  fabric_ = shared.fabric_;
+  domain_ = shared.domain_;
+  shared_ = true;
+  OpenEndpoint();
+}
+
+void Net::OpenEndpoint() {
+  struct fi_av_attr av_attr{};
+  struct fi_cq_attr cq_attr{};
+
+  cq_attr.format = FI_CQ_FORMAT_DATA;
+  CHECK(fi_cq_open(domain_, &cq_attr, &tx_cq_, nullptr));
+  CHECK(fi_cq_open(domain_, &cq_attr, &rx_cq_, nullptr));
+  CHECK(fi_av_open(domain_, &av_attr, &av_, nullptr));
+  CHECK(fi_endpoint(domain_, info_, &ep_, nullptr));
+  CHECK(fi_ep_bind(ep_, &tx_cq_->fid, FI_SEND));
+  CHECK(fi_ep_bind(ep_, &rx_cq_->fid, FI_RECV));
+  CHECK(fi_ep_bind(ep_, &av_->fid, 0));
+  CHECK(fi_enable(ep_));
+
+  size_t len = sizeof(addr_);
+  CHECK(fi_getname(&ep_->fid, addr_, &len));
+  Register();
+}
+
+Net::~Net() {
+  UnRegister();
+  // the endpoint goes before the queues bound to it
+  if (ep_) {
+    fi_close((fid_t)ep_);
+    ep_ = nullptr;
+  }
+  for (auto cq : {&tx_cq_, &rx_cq_}) {
+    if (*cq) fi_close((fid_t)*cq);
+    *cq = nullptr;
+  }
+  if (av_) {
+    fi_close((fid_t)av_);
+    av_ = nullptr;
+  }
+  // connections release their memory registrations before the domain closes
+  conns_.clear();
+  if (domain_ and !shared_) fi_close((fid_t)domain_);
+  domain_ = nullptr;
+  if (fabric_ and !shared_) fi_close((fid_t)fabric_);
+  fabric_ = nullptr;
+  if (info_) {
+    fi_freeinfo(info_);
+    info_ = nullptr;
+  }
+}
@@ -0,0 +1,48 @@
+#!/bin/bash
+
+set -exo pipefail
+
+DIR="$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+sqsh="${DIR}/../../efa+latest.sqsh"
+mount="/fsx:/fsx"
+binary="${DIR}/../../build/src/engine/engine"
+
+# one process per node drives every NIC; each rail's loop pins itself
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  --cpu-bind=none \
+  "${binary}" transfer 1000
+
+# posting cost and message rate per threading model, two workers per NIC
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  --cpu-bind=none \
+  "${binary}" post 2 1000000
+
+# progress engine: lock-free channels while the application threads compute
+for compute_us in 0 500; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --ntasks-per-node=1 \
+    --cpu-bind=none \
+    "${binary}" progress "${compute_us}" 1000
+done
+
+# small-message latency, idle and behind bulk transfers on the same rail
+for depth in 0 4; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --ntasks-per-node=1 \
+    --cpu-bind=none \
+    "${binary}" latency "${depth}" 10000
+done
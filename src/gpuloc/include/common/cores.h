@@ -0,0 +1,168 @@
+#pragma once
+
+#include <dirent.h>
+#include <hwloc.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/utils.h"
+
+/**
+ * @brief Physical core handed out by CoreAllocator
+ */
+struct PhysicalCore {
+  hwloc_obj_t core;      ///< hwloc core object
+  std::vector<int> pus;  ///< OS indices of its hardware threads (SMT siblings)
+  bool irq;              ///< whether it services an interrupt of the NIC
+};
+
+/**
+ * @brief Allocator of exclusive physical cores next to a GPU and its NIC
+ *
+ * GPUAffinity::cores lists NUMA-local cores; pinning to cores[local_rank]
+ * ignores that a core's SMT siblings are separate CPUs and that the NIC's
+ * completion interrupts may be steered to one of them. The allocator orders
+ * the cores so the ones servicing NIC interrupts come last and hands out
+ * whole cores: a thread is pinned to the first hardware thread and its
+ * siblings are never given to anyone else. Ranks sharing a NUMA node that
+ * pass the same NIC list, every NIC local to the node rather than each
+ * rank's own, compute the same order, so rank r taking slots
+ * [r * n, (r + 1) * n) never collides with another rank.
+ */
+class CoreAllocator : private NoCopy {
+ public:
+  /**
+   * @brief Order the given cores for allocation
+   * @param cores NUMA-local cores, e.g. GPUAffinity::cores
+   * @param nics PCI devices whose interrupts to avoid
+   */
+  CoreAllocator(const std::vector<hwloc_obj_t> &cores, const std::vector<hwloc_obj_t> &nics) {
+    std::set<int> local;
+    for (auto core : cores) {
+      PhysicalCore c{core, {}, false};
+      for (auto pu = core->first_child; !!pu; pu = pu->next_sibling) {
+        if (pu->type != HWLOC_OBJ_PU) continue;
+        c.pus.emplace_back(pu->os_index);
+        local.emplace(pu->os_index);
+      }
+      if (!c.pus.empty()) cores_.emplace_back(c);
+    }
+    for (auto nic : nics) {
+      for (auto irq : GetIRQs(nic)) {
+        auto cpus = GetIRQAffinity(irq);
+        // an IRQ allowed everywhere (no irqbalance, no effective list) says nothing about placement
+        if (std::includes(cpus.begin(), cpus.end(), local.begin(), local.end())) continue;
+        irq_cpus_.insert(cpus.begin(), cpus.end());
+      }
+    }
+    for (auto &c : cores_) {
+      for (auto pu : c.pus) c.irq |= irq_cpus_.count(pu) > 0;
+    }
+    std::stable_sort(cores_.begin(), cores_.end(), [](auto &x, auto &y) { return x.irq < y.irq; });
+  }
+
+  /**
+   * @brief Get the physical cores in allocation order
+   */
+  inline const std::vector<PhysicalCore> &GetCores() const noexcept { return cores_; }
+
+  /**
+   * @brief Get the CPUs the NIC's interrupts are steered to
+   */
+  inline const std::set<int> &GetIRQCPUs() const noexcept { return irq_cpus_; }
+
+  /**
+   * @brief Get exclusive physical cores for a rank's main loop and progress threads
+   * @param local_rank Rank among the ranks sharing these cores
+   * @param threads Cores per rank: the main loop plus its progress threads
+   * @return OS index of the CPU to pin each thread to, main loop first
+   * @throws std::runtime_error if the NUMA node has fewer physical cores than requested
+   */
+  std::vector<int> Allocate(size_t local_rank, size_t threads = 1) const {
+    auto first = local_rank * threads;
+    if (first + threads > cores_.size()) {
+      throw std::runtime_error(fmt::format("rank {} needs cores [{}, {}) but only {} physical cores are local", local_rank, first, first + threads,
+                                           cores_.size()));
+    }
+    std::vector<int> cpus;
+    for (size_t i = first; i < first + threads; ++i) {
+      if (cores_[i].irq) SPDLOG_WARN("rank {} shares core with NIC interrupts (cpu {})", local_rank, cores_[i].pus.front());
+      cpus.emplace_back(cores_[i].pus.front());
+    }
+    return cpus;
+  }
+
+  /**
+   * @brief Get the interrupt numbers of a PCI device
+   *
+   * Reads the MSI vectors from sysfs and, for devices without them, falls
+   * back to /proc/interrupts lines naming the device's PCI address.
+   *
+   * @param pci PCI device object
+   * @return IRQ numbers
+   */
+  static std::vector<int> GetIRQs(hwloc_obj_t pci) {
+    auto &attr = pci->attr->pcidev;
+    auto addr = fmt::format("{:04x}:{:02x}:{:02x}.{:01x}", attr.domain, attr.bus, attr.dev, attr.func);
+    std::vector<int> irqs;
+    auto path = fmt::format("/sys/bus/pci/devices/{}/msi_irqs", addr);
+    if (auto dir = opendir(path.c_str()); !!dir) {
+      while (auto entry = readdir(dir)) {
+        if (entry->d_name[0] != '.') irqs.emplace_back(std::atoi(entry->d_name));
+      }
+      closedir(dir);
+    }
+    if (!irqs.empty()) return irqs;
+
+    std::ifstream interrupts("/proc/interrupts");
+    std::string line;
+    while (std::getline(interrupts, line)) {
+      if (line.find(addr) == std::string::npos) continue;
+      irqs.emplace_back(std::atoi(line.c_str()));
+    }
+    return irqs;
+  }
+
+  /**
+   * @brief Get the CPUs an interrupt is delivered to
+   *
+   * Prefers effective_affinity_list, which names the CPU the kernel actually
+   * picked, over the configured smp_affinity_list.
+   *
+   * @param irq IRQ number
+   * @return OS indices of the CPUs
+   */
+  static std::vector<int> GetIRQAffinity(int irq) {
+    std::string list;
+    std::ifstream(fmt::format("/proc/irq/{}/effective_affinity_list", irq)) >> list;
+    if (list.empty()) std::ifstream(fmt::format("/proc/irq/{}/smp_affinity_list", irq)) >> list;
+    return ParseCPUList(list);
+  }
+
+  /**
+   * @brief Parse a kernel CPU list such as "0-3,8,10-11"
+   */
+  static std::vector<int> ParseCPUList(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+      if (range.empty()) continue;
+      auto dash = range.find('-');
+      int lo = std::stoi(range.substr(0, dash));
+      int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+      for (int c = lo; c <= hi; ++c) cpus.emplace_back(c);
+    }
+    return cpus;
+  }
+
+ private:
+  std::set<int> irq_cpus_;
+  std::vector<PhysicalCore> cores_;
+};
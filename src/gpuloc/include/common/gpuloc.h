@@ -3,10 +3,18 @@
 #include <hwloc.h>
 #include <spdlog/spdlog.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -33,6 +41,44 @@ constexpr uint16_t AMD_VENDOR_ID = 0x1002;
 
 using pci_type = std::unordered_set<hwloc_obj_t>;
 
+/**
+ * @brief Path of the topology cache for this boot of this host
+ *
+ * The file name carries the hostname and the kernel boot ID, so a reboot,
+ * which may renumber devices, or another host never picks up a stale file.
+ * GPULOC_CACHE_DIR selects the directory (default $XDG_CACHE_HOME, else
+ * /tmp/gpuloc-<uid>); setting it to an empty string disables the cache. The
+ * cache is trusted on load, so the directory must belong to the current user
+ * and be writable by nobody else; it is created with mode 0700 if missing.
+ *
+ * @return Cache path, or an empty string if caching is disabled
+ */
+inline std::string GetTopologyCachePath() {
+  auto env = std::getenv("GPULOC_CACHE_DIR");
+  auto xdg = std::getenv("XDG_CACHE_HOME");
+  std::string dir;
+  if (env) {
+    dir = env;
+  } else if (xdg and *xdg) {
+    dir = xdg;
+  } else {
+    dir = fmt::format("/tmp/gpuloc-{}", getuid());
+  }
+  if (dir.empty()) return {};
+  struct stat st;
+  if (mkdir(dir.c_str(), 0700) and errno != EEXIST) return {};
+  if (lstat(dir.c_str(), &st) or !S_ISDIR(st.st_mode) or st.st_uid != getuid() or (st.st_mode & (S_IWGRP | S_IWOTH))) {
+    SPDLOG_WARN("skip topology cache in {}: not a private directory of uid {}", dir, getuid());
+    return {};
+  }
+  char host[256] = {0};
+  if (gethostname(host, sizeof(host) - 1)) return {};
+  std::string boot_id;
+  std::ifstream("/proc/sys/kernel/random/boot_id") >> boot_id;
+  if (boot_id.empty()) return {};
+  return fmt::format("{}/gpuloc-{}-{}.xml", dir, host, boot_id);
+}
+
 /**
  * @brief Represents a NUMA node with its associated cores and PCI bridges
  */
@@ -49,16 +95,117 @@ class Hwloc : private NoCopy {
  public:
   /**
    * @brief Constructor - initializes hwloc topology and discovers hardware
+   * @param xml Topology exported by Export() to load instead of discovering, or empty
+   * @param thissystem Whether an imported topology describes the running host
    */
-  Hwloc() {
+  explicit Hwloc(const std::string &xml = {}, bool thissystem = true) : cached_{!xml.empty()} {
+    unsigned long flags = HWLOC_TOPOLOGY_FLAG_IMPORT_SUPPORT;
     GPULOC_CHECK(hwloc_topology_init(&topology_));
     GPULOC_CHECK(hwloc_topology_set_all_types_filter(topology_, HWLOC_TYPE_FILTER_KEEP_ALL));
     GPULOC_CHECK(hwloc_topology_set_io_types_filter(topology_, HWLOC_TYPE_FILTER_KEEP_IMPORTANT));
-    GPULOC_CHECK(hwloc_topology_set_flags(topology_, HWLOC_TOPOLOGY_FLAG_IMPORT_SUPPORT));
+    if (cached_) {
+      // the cache is keyed by host and boot, so a cached topology is this system
+      GPULOC_CHECK(hwloc_topology_set_xml(topology_, xml.c_str()));
+      if (thissystem) flags |= HWLOC_TOPOLOGY_FLAG_IS_THISSYSTEM;
+    }
+    GPULOC_CHECK(hwloc_topology_set_flags(topology_, flags));
     GPULOC_CHECK(hwloc_topology_load(topology_));
     Traverse(hwloc_get_root_obj(topology_), nullptr, numanodes_);
   }
 
+  /**
+   * @brief Load the topology from a cache file, discovering it if the file is missing, unreadable or not ours
+   * @param path Cache path from GetTopologyCachePath(), or empty to always discover
+   * @return Topology; IsCached() tells which way it was built
+   */
+  inline static Hwloc Load(const std::string &path) {
+    struct stat st;
+    if (!path.empty() and lstat(path.c_str(), &st) == 0) {
+      // hwloc follows symlinks, and a file planted by another user must not steer the placement
+      if (!S_ISREG(st.st_mode) or st.st_uid != getuid()) {
+        SPDLOG_WARN("ignore topology cache {}: not a regular file owned by uid {}", path, getuid());
+        return Hwloc();
+      }
+      try {
+        return Hwloc(path);
+      } catch (const std::runtime_error &e) {
+        SPDLOG_WARN("ignore topology cache {}: {}", path, e.what());
+      }
+    }
+    return Hwloc();
+  }
+
+  /**
+   * @brief Export the topology as XML
+   *
+   * The file is written to a fresh mkstemp() file next to path and renamed
+   * into place, so ranks starting concurrently never read a partial cache and
+   * the export never follows a link someone else put in its way. The cache only saves
+   * the next start some work, so a failure (missing directory, full disk,
+   * another user's file) is logged and the temporary file removed instead of
+   * throwing.
+   *
+   * @param path Destination file
+   * @return true if the file was written
+   */
+  bool Export(const std::string &path) const {
+    auto tmp = path + ".XXXXXX";
+    auto fd = mkstemp(tmp.data());
+    if (fd < 0) {
+      SPDLOG_WARN("skip topology cache {}: {}", path, strerror(errno));
+      return false;
+    }
+    close(fd);
+    if (hwloc_topology_export_xml(topology_, tmp.c_str(), 0) == 0 and rename(tmp.c_str(), path.c_str()) == 0) return true;
+    SPDLOG_WARN("skip topology cache {}: {}", path, strerror(errno));
+    unlink(tmp.c_str());
+    return false;
+  }
+
+  /**
+   * @brief Attach a key/value pair to the topology root; it is exported with the topology
+   * @param name Key
+   * @param value Value
+   */
+  void AddInfo(const char *name, const std::string &value) { GPULOC_CHECK(hwloc_obj_add_info(hwloc_get_root_obj(topology_), name, value.c_str())); }
+
+  /**
+   * @brief Get a key/value pair of the topology root
+   * @param name Key
+   * @return Value, or an empty string if absent
+   */
+  std::string GetInfo(const char *name) const {
+    auto value = hwloc_obj_get_info_by_name(hwloc_get_root_obj(topology_), name);
+    return value ? value : "";
+  }
+
+  /**
+   * @brief Check whether the topology was loaded from a cache file
+   */
+  bool IsCached() const noexcept { return cached_; }
+
+  /**
+   * @brief Relative NUMA latency between two NUMA nodes
+   *
+   * Taken from the hwloc latency matrix (the ACPI SLIT on most hosts) and
+   * normalized by the local latency of a. Without a matrix, remote nodes
+   * count as twice the local latency.
+   *
+   * @param a NUMA node
+   * @param b NUMA node
+   * @return 1.0 for local, larger for remote
+   */
+  double GetNumaLatency(hwloc_obj_t a, hwloc_obj_t b) const {
+    if (a == b) return 1.0;
+    unsigned nr = 1;
+    struct hwloc_distances_s *dist = nullptr;
+    if (hwloc_distances_get_by_type(topology_, HWLOC_OBJ_NUMANODE, &nr, &dist, HWLOC_DISTANCES_KIND_MEANS_LATENCY, 0) or nr == 0) return 2.0;
+    hwloc_uint64_t ab = 0, ba = 0, aa = 0;
+    auto found = hwloc_distances_obj_pair_values(dist, a, b, &ab, &ba) == 0 and hwloc_distances_obj_pair_values(dist, a, a, &aa, &aa) == 0 and aa;
+    hwloc_distances_release(topology_, dist);
+    return found ? (double)ab / aa : 2.0;
+  }
+
   /**
    * @brief Destructor - cleans up hwloc topology
    */
@@ -132,6 +279,16 @@ class Hwloc : private NoCopy {
     return true;
   }
 
+  /**
+   * @brief Check if PCI device is a network controller (PCI class 0x02)
+   * @param l hwloc object to check
+   * @return true if object is a network device
+   */
+  inline static bool IsNetwork(hwloc_obj_t l) {
+    if (l->type != HWLOC_OBJ_PCI_DEVICE) return false;
+    return (l->attr->pcidev.class_id >> 8) == 0x02;
+  }
+
   /**
    * @brief Check if object has OS device of specified type
    * @param type OS device type to check for
@@ -197,6 +354,7 @@ class Hwloc : private NoCopy {
 
  private:
   hwloc_topology_t topology_;
+  bool cached_;
   std::vector<Numanode> numanodes_;
 };
 
@@ -210,6 +368,160 @@ struct GPUAffinity {
   std::vector<hwloc_obj_t> efas;   ///< EFA devices on the same PCI bridge
 };
 
+/**
+ * @brief GPU x NIC placement cost and a balanced assignment
+ *
+ * The cost of a pair counts the edges of the topology tree between the two
+ * PCI devices, which grows with every PCIe switch or host bridge between
+ * them, plus kNumaWeight hops per unit of relative NUMA latency above local
+ * when they hang off different NUMA nodes.
+ */
+struct CostMatrix {
+  /** @brief Hops charged per unit of relative NUMA latency */
+  inline constexpr static double kNumaWeight = 4.0;
+
+  std::vector<hwloc_obj_t> gpus;              ///< GPUs by PCI address
+  std::vector<hwloc_obj_t> nics;              ///< NICs by PCI address
+  std::vector<std::vector<double>> cost;      ///< cost[gpu][nic]
+  std::vector<std::vector<size_t>> assigned;  ///< NIC indices per GPU
+
+  /**
+   * @brief Minimum-cost assignment of rows to distinct columns (Hungarian method)
+   * @param a Cost of rows x columns, rows <= columns
+   * @return Column of every row
+   */
+  static std::vector<size_t> Hungarian(const std::vector<std::vector<double>> &a) {
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    size_t n = a.size(), m = n ? a[0].size() : 0;
+    std::vector<double> u(n + 1, 0), v(m + 1, 0);
+    std::vector<size_t> p(m + 1, 0), way(m + 1, 0);
+    for (size_t i = 1; i <= n; ++i) {
+      p[0] = i;
+      size_t j0 = 0;
+      std::vector<double> minv(m + 1, inf);
+      std::vector<bool> used(m + 1, false);
+      do {
+        used[j0] = true;
+        size_t i0 = p[j0], j1 = 0;
+        double delta = inf;
+        for (size_t j = 1; j <= m; ++j) {
+          if (used[j]) continue;
+          auto cur = a[i0 - 1][j - 1] - u[i0] - v[j];
+          if (cur < minv[j]) {
+            minv[j] = cur;
+            way[j] = j0;
+          }
+          if (minv[j] < delta) {
+            delta = minv[j];
+            j1 = j;
+          }
+        }
+        for (size_t j = 0; j <= m; ++j) {
+          if (used[j]) {
+            u[p[j]] += delta;
+            v[j] -= delta;
+          } else {
+            minv[j] -= delta;
+          }
+        }
+        j0 = j1;
+      } while (p[j0] != 0);
+      do {
+        auto j1 = way[j0];
+        p[j0] = p[j1];
+        j0 = j1;
+      } while (j0);
+    }
+    std::vector<size_t> col(n);
+    for (size_t j = 1; j <= m; ++j) {
+      if (p[j]) col[p[j] - 1] = j - 1;
+    }
+    return col;
+  }
+
+  /**
+   * @brief Minimum-cost assignment of rows to columns that each take up to slots rows
+   * @param a Cost of rows x columns, rows <= columns * slots
+   * @param slots Rows a column can take
+   * @return Column of every row
+   */
+  static std::vector<size_t> Spread(const std::vector<std::vector<double>> &a, size_t slots) {
+    auto columns = a.empty() ? 0 : a[0].size();
+    std::vector<std::vector<double>> expanded(a.size(), std::vector<double>(columns * slots));
+    for (size_t r = 0; r < a.size(); ++r) {
+      for (size_t c = 0; c < columns * slots; ++c) expanded[r][c] = a[r][c / slots];
+    }
+    auto col = Hungarian(expanded);
+    for (auto &c : col) c /= slots;
+    return col;
+  }
+
+  /**
+   * @brief Assign NICs to GPUs at minimum total cost without oversubscribing either side
+   *
+   * Every GPU gets one NIC first. With fewer NICs than GPUs a NIC serves at
+   * most ceil(G / N) GPUs. With at least as many NICs, each GPU takes a
+   * distinct NIC, then the remaining NICs are spread over the GPUs so that no
+   * GPU ends up with more than ceil(N / G). Solving the one-per-GPU round
+   * separately keeps a cluster of NICs near some GPUs from leaving another
+   * GPU without any.
+   */
+  void Assign() {
+    auto G = gpus.size(), N = nics.size();
+    assigned.assign(G, {});
+    if (G == 0 or N == 0) return;
+    if (N < G) {
+      auto nic = Spread(cost, (G + N - 1) / N);
+      for (size_t g = 0; g < G; ++g) assigned[g].emplace_back(nic[g]);
+    } else {
+      std::vector<bool> taken(N, false);
+      auto first = Hungarian(cost);
+      for (size_t g = 0; g < G; ++g) {
+        assigned[g].emplace_back(first[g]);
+        taken[first[g]] = true;
+      }
+      std::vector<size_t> rest;
+      for (size_t n = 0; n < N; ++n) {
+        if (!taken[n]) rest.emplace_back(n);
+      }
+      std::vector<std::vector<double>> a(rest.size(), std::vector<double>(G));
+      for (size_t i = 0; i < rest.size(); ++i) {
+        for (size_t g = 0; g < G; ++g) a[i][g] = cost[g][rest[i]];
+      }
+      auto gpu = rest.empty() ? std::vector<size_t>{} : Spread(a, (N + G - 1) / G - 1);
+      for (size_t i = 0; i < rest.size(); ++i) assigned[gpu[i]].emplace_back(rest[i]);
+    }
+    for (size_t g = 0; g < G; ++g) {
+      std::sort(assigned[g].begin(), assigned[g].end(), [&](auto x, auto y) { return cost[g][x] < cost[g][y]; });
+    }
+  }
+
+  /**
+   * @brief Stream output operator printing the matrix with assigned pairs starred
+   * @param os Output stream
+   * @param m CostMatrix object to output
+   * @return Reference to output stream
+   */
+  friend std::ostream &operator<<(std::ostream &os, const CostMatrix &m) {
+    os << fmt::format("{:>13}", "");
+    for (auto nic : m.nics) {
+      os << fmt::format(" {:>9}", fmt::format("{:02x}:{:02x}.{:01x}", nic->attr->pcidev.bus, nic->attr->pcidev.dev, nic->attr->pcidev.func));
+    }
+    os << "\n";
+    for (size_t g = 0; g < m.gpus.size(); ++g) {
+      auto gpu = m.gpus[g];
+      os << fmt::format("GPU ({:02x}:{:02x}.{:01x})", gpu->attr->pcidev.bus, gpu->attr->pcidev.dev, gpu->attr->pcidev.func);
+      for (size_t n = 0; n < m.nics.size(); ++n) {
+        auto &a = m.assigned[g];
+        auto star = std::find(a.begin(), a.end(), n) != a.end() ? "*" : " ";
+        os << fmt::format(" {:>8.1f}{}", m.cost[g][n], star);
+      }
+      os << "\n";
+    }
+    return os;
+  }
+};
+
 /**
  * @brief GPU locality analyzer that maps GPUs to their optimal CPU and network resources
  */
@@ -218,14 +530,43 @@ class GPUloc : private NoCopy {
   using affinity_type = std::unordered_map<hwloc_obj_t, GPUAffinity>;
 
   inline static GPUloc &Get() {
-    static GPUloc loc;
+    static GPUloc loc(GetTopologyCachePath());
     return loc;
   }
 
   /**
    * @brief Constructor - discovers hardware topology and builds GPU affinity map
+   *
+   * With a cache path the topology is loaded from the cache when present and
+   * otherwise discovered and written to the cache for the next start.
+   *
+   * @param cache Cache path from GetTopologyCachePath(), or empty to always discover
+   */
+  explicit GPUloc(const std::string &cache = {}) : hwloc_{Hwloc::Load(cache)}, affinity_{GetAffinity(hwloc_)}, matrix_{GetCostMatrix(hwloc_)} {
+    if (!hwloc_.IsCached() and !cache.empty()) hwloc_.Export(cache);
+    AddAssignedEFAs();
+  }
+
+  /**
+   * @brief Build the GPU affinity of an hwloc XML topology from any host
+   *
+   * Unlike the cache path, the file is imported as a foreign system, a file
+   * that cannot be loaded throws instead of falling back to discovery, and
+   * nothing is ever written back.
+   *
+   * @param xml hwloc XML topology (e.g. from lstopo --of xml)
+   * @return GPU locality of the host the file describes
+   * @throws std::runtime_error if the file cannot be loaded
+   */
+  inline static GPUloc Import(const std::string &xml) {
+    if (xml.empty()) throw std::invalid_argument("topology file path is empty");
+    return GPUloc(Foreign{}, xml);
+  }
+
+  /**
+   * @brief Check whether the topology came from the cache
    */
-  GPUloc() : hwloc_{Hwloc()}, affinity_{GetAffinity(hwloc_)} {}
+  bool IsCached() const noexcept { return hwloc_.IsCached(); }
 
   /**
    * @brief Get GPU affinity mapping
@@ -233,7 +574,84 @@ class GPUloc : private NoCopy {
    */
   const affinity_type &GetGPUAffinity() const noexcept { return affinity_; }
 
+  /**
+   * @brief Get the GPU x NIC cost matrix and its balanced assignment
+   */
+  const CostMatrix &GetCostMatrix() const noexcept { return matrix_; }
+
  private:
+  /** @brief Tag selecting the foreign topology constructor */
+  struct Foreign {};
+
+  GPUloc(Foreign, const std::string &xml) : hwloc_{xml, false}, affinity_{GetAffinity(hwloc_)}, matrix_{GetCostMatrix(hwloc_)} { AddAssignedEFAs(); }
+
+  /**
+   * @brief Give a GPU without an EFA under its own host bridge its nearest assigned EFAs
+   */
+  void AddAssignedEFAs() {
+    for (size_t g = 0; g < matrix_.gpus.size(); ++g) {
+      auto &efas = affinity_[matrix_.gpus[g]].efas;
+      if (!efas.empty()) continue;
+      for (auto n : matrix_.assigned[g]) {
+        if (Hwloc::IsEFA(matrix_.nics[n])) efas.emplace_back(matrix_.nics[n]);
+      }
+    }
+  }
+
+  /**
+   * @brief Build the GPU x NIC cost matrix and assign NICs to GPUs
+   *
+   * NICs are the EFA devices, or every PCI network controller on hosts
+   * without EFA.
+   *
+   * @param hwloc Hardware topology object
+   * @return Cost matrix with assignment
+   */
+  static CostMatrix GetCostMatrix(const Hwloc &hwloc) {
+    CostMatrix m;
+    std::unordered_map<hwloc_obj_t, hwloc_obj_t> numa_of;
+    std::vector<hwloc_obj_t> efas, nets;
+    for (auto &numa : hwloc.GetNumaNodes()) {
+      for (auto &bridge : numa.bridge) {
+        for (auto pci : bridge.second) {
+          numa_of[pci] = numa.numanode;
+          if (Hwloc::IsGPU(pci)) {
+            m.gpus.emplace_back(pci);
+          } else if (Hwloc::IsEFA(pci)) {
+            efas.emplace_back(pci);
+          } else if (Hwloc::IsNetwork(pci)) {
+            nets.emplace_back(pci);
+          }
+        }
+      }
+    }
+    m.nics = efas.empty() ? nets : efas;
+    auto by_pci = [](auto &&x, auto &&y) {
+      auto &a = x->attr->pcidev;
+      auto &b = y->attr->pcidev;
+      return std::tie(a.domain, a.bus, a.dev, a.func) < std::tie(b.domain, b.bus, b.dev, b.func);
+    };
+    std::sort(m.gpus.begin(), m.gpus.end(), by_pci);
+    std::sort(m.nics.begin(), m.nics.end(), by_pci);
+
+    m.cost.assign(m.gpus.size(), std::vector<double>(m.nics.size()));
+    for (size_t g = 0; g < m.gpus.size(); ++g) {
+      std::vector<hwloc_obj_t> up;
+      for (auto p = m.gpus[g]; !!p; p = p->parent) up.emplace_back(p);
+      for (size_t n = 0; n < m.nics.size(); ++n) {
+        // edges from the NIC up to the closest common ancestor, then down to the GPU
+        size_t hops = 0;
+        auto q = m.nics[n];
+        for (; !!q and std::find(up.begin(), up.end(), q) == up.end(); q = q->parent) ++hops;
+        hops += std::find(up.begin(), up.end(), q) - up.begin();
+        auto latency = hwloc.GetNumaLatency(numa_of[m.gpus[g]], numa_of[m.nics[n]]);
+        m.cost[g][n] = hops + CostMatrix::kNumaWeight * (latency - 1.0);
+      }
+    }
+    m.Assign();
+    return m;
+  }
+
   /**
    * @brief Build GPU affinity mapping from hardware topology
    * @param hwloc Hardware topology object
@@ -284,6 +702,134 @@ class GPUloc : private NoCopy {
     return os;
   }
 
+ private:
+  Hwloc hwloc_;
+  affinity_type affinity_;
+  CostMatrix matrix_;
+};
+
+/**
+ * @brief NIC affinity: the NUMA node and cores local to a NIC
+ */
+struct NicAffinity {
+  hwloc_obj_t nic;                 ///< NIC PCI device object
+  hwloc_obj_t numanode;            ///< Associated NUMA node
+  std::vector<hwloc_obj_t> cores;  ///< CPU cores in the same NUMA node
+};
+
+/**
+ * @brief Core assigned to a local rank next to a NIC
+ */
+struct NicBinding {
+  size_t rank;       ///< local rank
+  size_t nic;        ///< index into NicLoc::GetNicAffinity()
+  hwloc_obj_t core;  ///< NIC-local core
+};
+
+/**
+ * @brief NIC locality analyzer for hosts without GPUs
+ *
+ * Built from the same Hwloc::Traverse data as GPUloc but keyed by NIC, so it
+ * needs neither GPUs nor NVML. OpenFabrics devices (EFA) are preferred; when
+ * a host has none, every PCI network controller counts as a NIC, which lets
+ * the mapping be tried against an XML topology of any Linux box.
+ */
+class NicLoc : private NoCopy {
+ public:
+  using affinity_type = std::vector<NicAffinity>;
+
+  inline static NicLoc &Get() {
+    static NicLoc loc;
+    return loc;
+  }
+
+  /**
+   * @brief Constructor - loads a topology and builds the NIC affinity list
+   * @param xml hwloc XML topology of any host (e.g. from lstopo --of xml), or empty for this host through the cache
+   */
+  explicit NicLoc(const std::string &xml = {})
+      : hwloc_{xml.empty() ? Hwloc::Load(GetTopologyCachePath()) : Hwloc(xml, false)}, affinity_{GetAffinity(hwloc_)} {}
+
+  /**
+   * @brief Get NIC affinity, ordered by PCI address
+   * @return Reference to NIC affinity list
+   */
+  const affinity_type &GetNicAffinity() const noexcept { return affinity_; }
+
+  /**
+   * @brief Hand out NIC-local cores to local ranks
+   *
+   * Rank r uses NIC r mod N and the first core of that NIC's NUMA node no
+   * earlier rank got, so NICs sharing a NUMA node never hand out a core twice.
+   *
+   * @param ranks Number of local ranks
+   * @return One binding per rank
+   * @throws std::runtime_error if there is no NIC or a NUMA node runs out of cores
+   */
+  std::vector<NicBinding> Assign(size_t ranks) const {
+    if (affinity_.empty()) throw std::runtime_error("no NIC found in topology");
+    std::unordered_set<hwloc_obj_t> used;
+    std::vector<NicBinding> bindings;
+    for (size_t r = 0; r < ranks; ++r) {
+      auto nic = r % affinity_.size();
+      auto &cores = affinity_[nic].cores;
+      auto it = std::find_if(cores.begin(), cores.end(), [&](auto core) { return !used.count(core); });
+      if (it == cores.end()) throw std::runtime_error(fmt::format("no free core local to NIC {} for rank {}", nic, r));
+      used.emplace(*it);
+      bindings.emplace_back(NicBinding{r, nic, *it});
+    }
+    return bindings;
+  }
+
+ private:
+  /**
+   * @brief Build NIC affinity list from hardware topology
+   * @param hwloc Hardware topology object
+   * @return NIC affinity list
+   */
+  static affinity_type GetAffinity(Hwloc &hwloc) {
+    affinity_type efas, nics;
+    for (auto &numa : hwloc.GetNumaNodes()) {
+      std::vector<hwloc_obj_t> cores(numa.cores.begin(), numa.cores.end());
+      std::sort(cores.begin(), cores.end(), [](auto &&x, auto &&y) { return x->logical_index < y->logical_index; });
+      for (auto &bridge : numa.bridge) {
+        for (auto pci : bridge.second) {
+          if (Hwloc::IsEFA(pci)) {
+            efas.emplace_back(NicAffinity{pci, numa.numanode, cores});
+          } else if (Hwloc::IsNetwork(pci)) {
+            nics.emplace_back(NicAffinity{pci, numa.numanode, cores});
+          }
+        }
+      }
+    }
+    auto &affinity = efas.empty() ? nics : efas;
+    std::sort(affinity.begin(), affinity.end(), [](auto &&x, auto &&y) {
+      auto &a = x.nic->attr->pcidev;
+      auto &b = y.nic->attr->pcidev;
+      return std::tie(a.domain, a.bus, a.dev, a.func) < std::tie(b.domain, b.bus, b.dev, b.func);
+    });
+    return affinity;
+  }
+
+  /**
+   * @brief Stream output operator for NicLoc
+   * @param os Output stream
+   * @param loc NicLoc object to output
+   * @return Reference to output stream
+   */
+  friend std::ostream &operator<<(std::ostream &os, const NicLoc &loc) {
+    for (size_t i = 0; i < loc.affinity_.size(); ++i) {
+      auto &affinity = loc.affinity_[i];
+      auto nic = affinity.nic;
+      auto &cores = affinity.cores;
+      os << fmt::format("NIC({}) ({:02x}:{:02x}.{:01x})", i, nic->attr->pcidev.bus, nic->attr->pcidev.dev, nic->attr->pcidev.func);
+      os << fmt::format(" NUMA{}", affinity.numanode->logical_index);
+      if (!cores.empty()) os << fmt::format(" Core{:>2}-Core{:>2}", cores.front()->logical_index, cores.back()->logical_index);
+      os << "\n";
+    }
+    return os;
+  }
+
  private:
   Hwloc hwloc_;
   affinity_type affinity_;
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/cores.h"
+#include "common/gpuloc.h"
+
+/**
+ * @brief Resources planned for one local rank
+ */
+struct Placement {
+  size_t rank;            ///< local rank
+  int gpu;                ///< GPU index in PCI order, -1 on hosts without GPUs
+  hwloc_obj_t gpu_obj;    ///< GPU device object, or nullptr
+  hwloc_obj_t nic;        ///< NIC device object, or nullptr
+  hwloc_obj_t numanode;   ///< NUMA node to bind memory to
+  std::vector<int> cpus;  ///< OS index of the first hardware thread of each exclusive core
+};
+
+/**
+ * @brief Placement planner for the ranks of one node
+ *
+ * Rank r gets GPU r mod G, one of the NICs the cost matrix assigned to that
+ * GPU, the GPU's NUMA node and threads exclusive physical cores from
+ * CoreAllocator; ranks sharing a NUMA node take consecutive slots. On hosts
+ * without GPUs the ranks are spread over NicLoc's NICs instead. GPU indices
+ * follow PCI order, which matches local_rank based cudaSetDevice in the
+ * examples, so the launcher flags bind CPUs and memory only.
+ */
+class Planner : private NoCopy {
+ public:
+  /**
+   * @brief Load the topology
+   * @param xml hwloc XML topology of any host, imported read-only, or empty for this host through the cache
+   */
+  explicit Planner(const std::string &xml = {})
+      : gpuloc_{xml.empty() ? GPUloc(GetTopologyCachePath()) : GPUloc::Import(xml)}, nicloc_{xml}, thissystem_{xml.empty()} {}
+
+  /**
+   * @brief Plan every local rank
+   * @param ranks Ranks per node
+   * @param threads Cores per rank: the main loop plus its progress threads
+   * @return One placement per rank
+   * @throws std::runtime_error if the node has no GPU and no NIC or runs out of cores
+   */
+  std::vector<Placement> Plan(size_t ranks, size_t threads) const {
+    auto &m = gpuloc_.GetCostMatrix();
+    auto &gpus = m.gpus;
+    std::vector<Placement> plan;
+    std::vector<std::vector<hwloc_obj_t>> cores;
+    for (size_t r = 0; r < ranks; ++r) {
+      Placement p{r, -1, nullptr, nullptr, nullptr, {}};
+      if (!gpus.empty()) {
+        auto g = r % gpus.size();
+        auto &affinity = gpuloc_.GetGPUAffinity().at(gpus[g]);
+        auto &assigned = m.assigned[g];
+        p.gpu = g;
+        p.gpu_obj = gpus[g];
+        p.numanode = affinity.numanode;
+        if (!assigned.empty()) p.nic = m.nics[assigned[r / gpus.size() % assigned.size()]];
+        cores.emplace_back(affinity.cores);
+      } else {
+        auto &nics = nicloc_.GetNicAffinity();
+        if (nics.empty()) throw std::runtime_error("no GPU and no NIC found in topology");
+        auto &affinity = nics[r % nics.size()];
+        p.nic = affinity.nic;
+        p.numanode = affinity.numanode;
+        cores.emplace_back(affinity.cores);
+      }
+      plan.emplace_back(p);
+    }
+
+    // ranks sharing a NUMA node take consecutive slots of one allocator; the
+    // interrupts of a topology file's host cannot be read from here
+    std::vector<hwloc_obj_t> irq_nics = thissystem_ ? m.nics : std::vector<hwloc_obj_t>{};
+    std::map<hwloc_obj_t, std::unique_ptr<CoreAllocator>> allocators;
+    std::map<hwloc_obj_t, size_t> slots;
+    for (size_t r = 0; r < ranks; ++r) {
+      auto &p = plan[r];
+      auto &allocator = allocators[p.numanode];
+      if (!allocator) allocator = std::make_unique<CoreAllocator>(cores[r], irq_nics);
+      p.cpus = allocator->Allocate(slots[p.numanode]++, threads);
+    }
+    return plan;
+  }
+
+  /**
+   * @brief Format a plan as JSON
+   */
+  static std::string ToJSON(const std::vector<Placement> &plan, size_t threads) {
+    std::string out = fmt::format("{{\n  \"ranks_per_node\": {},\n  \"threads_per_rank\": {},\n  \"ranks\": [\n", plan.size(), threads);
+    for (auto &p : plan) {
+      out += fmt::format("    {{\"local_rank\": {}, \"gpu\": {}, ", p.rank, p.gpu);
+      out += fmt::format("\"gpu_pci\": \"{}\", \"nic_pci\": \"{}\", ", PCI(p.gpu_obj), PCI(p.nic));
+      out += fmt::format("\"numa\": {}, \"cpus\": [{}]}}{}\n", p.numanode ? (int)p.numanode->os_index : -1, fmt::join(p.cpus, ", "),
+                         &p == &plan.back() ? "" : ",");
+    }
+    return out + "  ]\n}\n";
+  }
+
+  /**
+   * @brief Format a plan as srun flags binding each task's CPUs and memory
+   */
+  static std::string ToSrun(const std::vector<Placement> &plan) {
+    std::vector<std::string> masks, mems;
+    for (auto &p : plan) {
+      masks.emplace_back(Mask(p.cpus));
+      mems.emplace_back(std::to_string(p.numanode ? p.numanode->os_index : 0));
+    }
+    return fmt::format("--ntasks-per-node={} --cpu-bind=mask_cpu:{} --mem-bind=map_mem:{}", plan.size(), fmt::join(masks, ","), fmt::join(mems, ","));
+  }
+
+  /**
+   * @brief Format a plan as mpirun flags plus a wrapper that binds by local rank
+   *
+   * mpirun has no per-rank CPU list outside of rankfiles, whose slot syntax
+   * differs between MPI implementations, so ranks are started unbound and the
+   * wrapper applies the plan with numactl using the launcher's local rank.
+   */
+  static std::string ToMpirun(const std::vector<Placement> &plan) {
+    std::string out = fmt::format("#!/bin/bash\n# usage: mpirun --map-by ppr:{}:node --bind-to none ./bind.sh <binary> [args]\n", plan.size());
+    out += "case \"${OMPI_COMM_WORLD_LOCAL_RANK:-${MPI_LOCALRANKID:-${SLURM_LOCALID:-0}}}\" in\n";
+    for (auto &p : plan) {
+      out += fmt::format("  {}) exec numactl --physcpubind={} --membind={} \"$@\" ;;\n", p.rank, fmt::join(p.cpus, ","),
+                         p.numanode ? p.numanode->os_index : 0);
+    }
+    return out + "esac\n";
+  }
+
+ private:
+  inline static std::string PCI(hwloc_obj_t obj) {
+    if (!obj) return "";
+    auto &a = obj->attr->pcidev;
+    return fmt::format("{:04x}:{:02x}:{:02x}.{:01x}", a.domain, a.bus, a.dev, a.func);
+  }
+
+  /** @brief Hexadecimal CPU mask as taken by srun --cpu-bind=mask_cpu */
+  inline static std::string Mask(const std::vector<int> &cpus) {
+    std::vector<int> nibbles;
+    for (auto cpu : cpus) {
+      if ((size_t)cpu / 4 >= nibbles.size()) nibbles.resize(cpu / 4 + 1, 0);
+      nibbles[cpu / 4] |= 1 << (cpu % 4);
+    }
+    std::string hex = "0x";
+    for (auto it = nibbles.rbegin(); it != nibbles.rend(); ++it) hex += "0123456789abcdef"[*it];
+    return hex;
+  }
+
+ private:
+  GPUloc gpuloc_;
+  NicLoc nicloc_;
+  bool thissystem_;
+};
@@ -1,8 +1,115 @@
+#include <chrono>
 #include <iostream>
+#include <string>
 
 #include "common/gpuloc.h"
+#include "common/planner.h"
 
+/**
+ * @brief Time cold discovery against loading the topology cache
+ * @param iters Constructions timed per path
+ */
+static void Time(size_t iters) {
+  using clock = std::chrono::steady_clock;
+  auto path = GetTopologyCachePath();
+  if (path.empty()) throw std::runtime_error("topology cache disabled (GPULOC_CACHE_DIR is empty or boot ID unavailable)");
+
+  double cold = 0, cached = 0;
+  size_t gpus = 0;
+  for (size_t i = 0; i < iters; ++i) {
+    auto start = clock::now();
+    GPUloc loc;
+    cold += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    gpus = loc.GetGPUAffinity().size();
+  }
+
+  { GPUloc warm(path); }
+  for (size_t i = 0; i < iters; ++i) {
+    auto start = clock::now();
+    GPUloc loc(path);
+    cached += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    if (!loc.IsCached() or loc.GetGPUAffinity().size() != gpus) throw std::runtime_error(fmt::format("cache {} does not match discovery", path));
+  }
+  std::cout << fmt::format("cache={}\ngpus={} cold={:.2f}ms cached={:.2f}ms speedup={:.1f}x", path, gpus, cold / iters, cached / iters, cold / cached)
+            << std::endl;
+}
+
+/**
+ * @brief Print NIC affinity and the core each local rank would be bound to
+ * @param xml hwloc XML topology, or empty for this host
+ * @param ranks Local ranks to assign
+ */
+static void Nic(const std::string &xml, size_t ranks) {
+  auto loc = NicLoc(xml);
+  std::cout << loc;
+  for (auto &b : loc.Assign(ranks)) std::cout << fmt::format("rank {} -> NIC({}) Core{}", b.rank, b.nic, b.core->logical_index) << std::endl;
+}
+
+/**
+ * @brief Print the GPU x NIC cost matrix; starred entries are the balanced assignment
+ * @param xml hwloc XML topology, or empty for this host
+ */
+static void Matrix(const std::string &xml) {
+  auto loc = xml.empty() ? GPUloc(GetTopologyCachePath()) : GPUloc::Import(xml);
+  auto &m = loc.GetCostMatrix();
+  std::cout << fmt::format("gpus={} nics={} (cost = PCIe hops + {} x relative NUMA latency above local)", m.gpus.size(), m.nics.size(),
+                           CostMatrix::kNumaWeight)
+            << std::endl;
+  std::cout << m;
+}
+
+/**
+ * @brief Print the placement of every local rank
+ * @param ranks Ranks per node
+ * @param threads Cores per rank
+ * @param format json, srun or mpirun
+ * @param xml hwloc XML topology, or empty for this host
+ */
+static void Plan(size_t ranks, size_t threads, const std::string &format, const std::string &xml) {
+  auto planner = Planner(xml);
+  auto plan = planner.Plan(ranks, threads);
+  if (format == "json") {
+    std::cout << Planner::ToJSON(plan, threads);
+  } else if (format == "srun") {
+    std::cout << Planner::ToSrun(plan) << std::endl;
+  } else if (format == "mpirun") {
+    std::cout << Planner::ToMpirun(plan);
+  } else {
+    throw std::invalid_argument(fmt::format("unknown plan format {}", format));
+  }
+}
+
+/**
+ * usage: gpuloc [time [iters] | nic [ranks] [topology.xml] | matrix [topology.xml] |
+ *               plan <ranks_per_node> [threads_per_rank] [json|srun|mpirun] [topology.xml]]
+ *
+ * Without arguments, print the GPU affinity, using the topology cache.
+ * time: compare cold discovery against loading the cache.
+ * nic: print NIC-local NUMA nodes and cores and bind ranks to them, without
+ * GPUs or NVML; a topology from lstopo --of xml can stand in for this host.
+ * matrix: print the GPU x NIC cost matrix and the balanced NIC assignment.
+ * plan: GPU, NIC, NUMA node and exclusive cores of every local rank, as JSON
+ * or as launcher flags.
+ */
 int main(int argc, char *argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "";
+  if (mode == "time") {
+    Time(argc > 2 ? std::stoul(argv[2]) : 5);
+    return 0;
+  }
+  if (mode == "nic") {
+    Nic(argc > 3 ? argv[3] : "", argc > 2 ? std::stoul(argv[2]) : 1);
+    return 0;
+  }
+  if (mode == "plan") {
+    if (argc < 3) throw std::invalid_argument("plan needs ranks per node");
+    Plan(std::stoul(argv[2]), argc > 3 ? std::stoul(argv[3]) : 1, argc > 4 ? argv[4] : "json", argc > 5 ? argv[5] : "");
+    return 0;
+  }
+  if (mode == "matrix") {
+    Matrix(argc > 2 ? argv[2] : "");
+    return 0;
+  }
   auto &loc = GPUloc::Get();
   std::cout << loc;
 }
@@ -0,0 +1,215 @@
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/coro.h"
+#include "common/efa.h"
+#include "common/future.h"
+#include "common/mpi.h"
+#include "common/net.h"
+#include "common/runner.h"
+
+static void AllGatherAddr(const char *addr, int rank, std::string &endpoints) {
+  std::memcpy(endpoints.data() + ENDPOINT_IDX(rank), addr, kMaxAddrSize);
+  MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, endpoints.data(), kMaxAddrSize, MPI_BYTE, MPI_COMM_WORLD);
+}
+
+/**
+ * @brief Busy-wait to emulate per-message work of a slow consumer
+ * @param delay Time spent on each message
+ */
+static void Spin(std::chrono::nanoseconds delay) {
+  auto end = std::chrono::steady_clock::now() + delay;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+class Peer : private NoCopy {
+ public:
+  Peer() = delete;
+  Peer(int peer, size_t window) : net_{Net()}, peer_{peer}, window_{window} {
+    auto &mpi = MPI::Get();
+    auto &efa = EFA::Get();
+    auto rank = mpi.GetWorldRank();
+    net_.Open(efa.GetEFAInfo(), efa.GetShmInfo());
+
+    char remote[kMaxAddrSize] = {0};
+    std::string endpoints(mpi.GetWorldSize() * kMaxAddrSize, 0);
+    AllGatherAddr(net_.GetAddr(), rank, endpoints);
+    std::memcpy(remote, endpoints.data() + ENDPOINT_IDX(peer), kMaxAddrSize);
+    conn_ = net_.Connect(remote, window_);
+    ASSERT(!!conn_);
+    auto path = net_.IsLocal(remote) ? "shm" : "efa";
+    std::cout << fmt::format("[RANK:{}] peer={} path={} window={}", rank, peer, path, window_) << std::endl;
+    // every receive slot of both sides is posted once all ranks pass here
+    MPI_Barrier(MPI_COMM_WORLD);
+  }
+
+ protected:
+  inline static void Report(const char *role, std::chrono::steady_clock::time_point start, size_t msgs, size_t size, size_t window) {
+    auto end = std::chrono::steady_clock::now();
+    auto elapse = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / 1e9;
+    auto rate = msgs / elapse / 1e6;
+    auto bw = msgs * size * 8 / elapse / 1e9;
+    std::cout << fmt::format("[{}] window={} msgs={} size={} elapse={:.3f}s rate={:.3f}Mmsg/s bw={:.3f}Gbps", role, window, msgs, size, elapse,
+                             rate, bw)
+              << std::endl;
+  }
+
+ protected:
+  Net net_;
+  int peer_;
+  size_t window_;
+  Conn *conn_;
+};
+
+class Producer : public Peer {
+ public:
+  Producer(int peer, size_t window) : Peer(peer, window) {}
+
+  Coro<> Send(size_t msgs, size_t size) {
+    std::vector<char> data(size, 'x');
+    // without credits Send copies into a single send buffer, so only one
+    // message can be in flight
+    const size_t depth = window_ ? window_ : 1;
+    std::deque<Future<Coro<size_t>>> futs;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < msgs; ++i) {
+      while (futs.size() >= depth) {
+        co_await futs.front();
+        futs.pop_front();
+      }
+      futs.emplace_back(Future(conn_->Send(data.data(), size)));
+    }
+    for (auto &fut : futs) co_await fut;
+    Report("producer", start, msgs, size, window_);
+  }
+};
+
+class Consumer : public Peer {
+ public:
+  Consumer(int peer, size_t window) : Peer(peer, window) {}
+
+  Coro<> Recv(size_t msgs, size_t size, std::chrono::nanoseconds delay) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < msgs; ++i) {
+      auto [buf, len] = co_await conn_->Recv();
+      ASSERT(len == size);
+      Spin(delay);
+    }
+    Report("consumer", start, msgs, size, window_);
+  }
+};
+
+/**
+ * @brief Ping-pong latency per message size under eager and rendezvous sends
+ *
+ * Rank 0 sends a message of each size from its write buffer, rank 1 answers
+ * with a 1-byte pong. Every size runs twice: once with the default threshold
+ * (eager whenever the payload fits a receive slot) and once with threshold 0,
+ * which forces the rendezvous path.
+ */
+class Crossover : public Peer {
+ public:
+  Crossover(int peer, size_t window) : Peer(peer, window) {}
+
+  Coro<> Run(bool initiator) {
+    if (initiator) {
+      std::cout << fmt::format("{:>10} {:>12} {:>16} {:>12}", "size", "eager(us)", "rendezvous(us)", "winner") << std::endl;
+    }
+    for (size_t size = kMinSize; size <= kMaxSize; size <<= 1) {
+      // only the pinging side switches protocols; pongs always go eagerly
+      double eager = -1;
+      if (size <= kMaxEagerSize) {
+        if (initiator) conn_->SetEagerThreshold(kMaxEagerSize);
+        eager = co_await PingPong(initiator, size);
+      }
+      if (initiator) conn_->SetEagerThreshold(0);
+      auto rndv = co_await PingPong(initiator, size);
+      if (!initiator) continue;
+      auto e = eager < 0 ? std::string("N/A") : fmt::format("{:.2f}", eager);
+      auto winner = eager >= 0 and eager <= rndv ? "eager" : "rendezvous";
+      std::cout << fmt::format("{:>10} {:>12} {:>16.2f} {:>12}", size, e, rndv, winner) << std::endl;
+    }
+  }
+
+ private:
+  /**
+   * @brief Measure the average one-way latency of a message size
+   * @return Half of the mean round-trip time in microseconds
+   */
+  Coro<double> PingPong(bool initiator, size_t size) {
+    auto data = (const char *)conn_->GetWriteBuffer().GetData();
+    auto dst = (char *)conn_->GetReadBuffer().GetData();
+    const char pong = 0;
+    std::chrono::steady_clock::time_point start;
+    for (size_t i = 0; i < kWarmup + kIters; ++i) {
+      if (i == kWarmup) start = std::chrono::steady_clock::now();
+      if (initiator) {
+        co_await conn_->Send(data, size);
+        co_await conn_->Recv();
+      } else {
+        // rendezvous payloads land directly in the read buffer, without a copy
+        auto len = co_await conn_->Recv(dst, conn_->GetReadBuffer().GetSize());
+        ASSERT(len == size);
+        co_await conn_->Send(&pong, sizeof(pong));
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    co_return std::chrono::duration<double, std::micro>(end - start).count() / kIters / 2;
+  }
+
+  static constexpr size_t kMinSize = 64;
+  static constexpr size_t kMaxSize = 4UL << 20;
+  static constexpr size_t kWarmup = 100;
+  static constexpr size_t kIters = 1000;
+};
+
+Coro<> StartCrossover(size_t window) {
+  auto rank = MPI::Get().GetWorldRank();
+  auto crossover = Crossover(rank ^ 1, window);
+  co_await crossover.Run(rank == 0);
+}
+
+Coro<> StartProducer(size_t window, size_t msgs, size_t size) {
+  auto producer = Producer(1, window);
+  co_await producer.Send(msgs, size);
+}
+
+Coro<> StartConsumer(size_t window, size_t msgs, size_t size, std::chrono::nanoseconds delay) {
+  auto consumer = Consumer(0, window);
+  co_await consumer.Recv(msgs, size, delay);
+}
+
+/**
+ * usage: sendrecv [window] [delay_ns]
+ *        sendrecv crossover [window]
+ *
+ * window=0 runs the original send/recv path without flow control. The
+ * crossover mode prints eager vs rendezvous latency per message size.
+ */
+int main(int argc, char *argv[]) {
+  auto &mpi = MPI::Get();
+  ASSERT(mpi.GetWorldSize() == 2);
+
+  if (argc > 1 and std::string_view(argv[1]) == "crossover") {
+    const size_t window = argc > 2 ? std::stoul(argv[2]) : 16;
+    ASSERT(window > 0);
+    Run(StartCrossover(window));
+    return 0;
+  }
+
+  const size_t window = argc > 1 ? std::stoul(argv[1]) : 16;
+  const auto delay = std::chrono::nanoseconds(argc > 2 ? std::stoul(argv[2]) : 1000);
+  constexpr size_t msgs = 1000000;
+  constexpr size_t size = 64;
+  if (mpi.GetWorldRank() == 0) {
+    Run(StartProducer(window, msgs, size));
+  } else {
+    Run(StartConsumer(window, msgs, size, delay));
+  }
+}
@@ -0,0 +1,27 @@
+#!/bin/bash
+
+set -exo pipefail
+
+DIR="$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+sqsh="${DIR}/../../efa+latest.sqsh"
+mount="/fsx:/fsx"
+binary="${DIR}/../../build/src/sendrecv/sendrecv"
+
+# message rate with a consumer spending 1us per message, without (window=0)
+# and with credit-based flow control
+for window in 0 16 64; do
+  srun --container-image "${sqsh}" \
+    --container-mounts "${mount}" \
+    --container-name efa \
+    --mpi=pmix \
+    --ntasks-per-node=1 \
+    "${binary}" "${window}" 1000
+done
+
+# eager vs rendezvous latency per message size
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --ntasks-per-node=1 \
+  "${binary}" crossover 16
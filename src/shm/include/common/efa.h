@@ -0,0 +1,119 @@
+#pragma once
+
+#include <rdma/fabric.h>
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+
+#include "common/utils.h"
+
+/**
+ * @brief Singleton class for EFA (Elastic Fabric Adapter) initialization and management
+ */
+class EFA : private NoCopy {
+ public:
+  /**
+   * @brief Get singleton EFA instance
+   * @return Reference to the EFA singleton
+   */
+  inline static EFA &Get() {
+    static EFA efa;
+    return efa;
+  }
+
+  /**
+   * @brief Get EFA fabric information
+   * @return Pointer to fabric info structure, or nullptr if no EFA device exists
+   */
+  struct fi_info *GetEFAInfo() { return info_; }
+
+  /**
+   * @brief Get shared-memory fabric information for intra-node peers
+   * @return Pointer to fabric info structure, or nullptr if shm is unavailable
+   */
+  struct fi_info *GetShmInfo() { return shm_info_; }
+
+ private:
+  EFA() : info_{GetInfo("efa", kEFACaps)}, shm_info_{GetInfo("shm", kShmCaps)} { ASSERT(info_ or shm_info_); }
+  ~EFA() {
+    if (info_) {
+      fi_freeinfo(info_);
+      info_ = nullptr;
+    }
+    if (shm_info_) {
+      fi_freeinfo(shm_info_);
+      shm_info_ = nullptr;
+    }
+  }
+
+  /** @brief Capabilities requested from the EFA provider */
+  inline static constexpr uint64_t kEFACaps = FI_MSG | FI_RMA | FI_LOCAL_COMM | FI_REMOTE_COMM;
+  /** @brief Capabilities requested from the shm provider (local peers only) */
+  inline static constexpr uint64_t kShmCaps = FI_MSG | FI_RMA | FI_LOCAL_COMM;
+
+  /**
+   * @brief Query fabric information for a provider
+   * @param prov Provider name (e.g. "efa" or "shm")
+   * @param caps Capabilities requested from the provider
+   * @return Fabric info list, or nullptr if the provider is unavailable
+   */
+  inline static struct fi_info *GetInfo(const char *prov, uint64_t caps) {
+    int rc = 0;
+    struct fi_info *hints = nullptr;
+    struct fi_info *info = nullptr;
+    hints = fi_allocinfo();
+    if (!hints) {
+      SPDLOG_ERROR("fi_allocinfo fail.");
+      goto end;
+    }
+
+    hints->caps = caps;
+    hints->ep_attr->type = FI_EP_RDM;
+    hints->fabric_attr->prov_name = strdup(prov);
+    hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_VIRT_ADDR | FI_MR_ALLOCATED | FI_MR_PROV_KEY;
+    hints->domain_attr->threading = FI_THREAD_SAFE;
+
+    rc = fi_getinfo(FI_VERSION(1, 20), NULL, NULL, 0, hints, &info);
+    if (rc != 0) {
+      SPDLOG_WARN("fi_getinfo({}) fail. error({}): {}", prov, rc, fi_strerror(-rc));
+      goto error;
+    } else {
+      goto end;
+    }
+
+  error:
+    if (info) {
+      fi_freeinfo(info);
+      info = nullptr;
+    }
+
+  end:
+    if (hints) {
+      fi_freeinfo(hints);
+      hints = nullptr;
+    }
+    return info;
+  }
+
+ private:
+  friend std::ostream &operator<<(std::ostream &os, const EFA &efa) {
+    Print(os, efa.info_);
+    Print(os, efa.shm_info_);
+    return os;
+  }
+
+  inline static void Print(std::ostream &os, struct fi_info *info) {
+    for (auto cur = info; !!cur; cur = cur->next) {
+      os << fmt::format("provider: {}\n", cur->fabric_attr->prov_name);
+      os << fmt::format("    fabric: {}\n", cur->fabric_attr->name);
+      os << fmt::format("    domain: {}\n", cur->domain_attr->name);
+      os << fmt::format("    version: {}.{}\n", FI_MAJOR(cur->fabric_attr->prov_version), FI_MINOR(cur->fabric_attr->prov_version));
+      os << fmt::format("    type: {}\n", fi_tostr(&cur->ep_attr->type, FI_TYPE_EP_TYPE));
+      os << fmt::format("    protocol: {}\n", fi_tostr(&cur->ep_attr->protocol, FI_TYPE_PROTOCOL));
+    }
+  }
+
+ private:
+  struct fi_info *info_ = nullptr;
+  struct fi_info *shm_info_ = nullptr;
+};
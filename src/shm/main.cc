@@ -0,0 +1,234 @@
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/coro.h"
+#include "common/efa.h"
+#include "common/mpi.h"
+#include "common/net.h"
+#include "common/progress.h"
+#include "common/runner.h"
+#include "common/timer.h"
+
+#define MSGSIZE(msg) (sizeof(Message) + (sizeof(HostRegion) * msg->num))
+constexpr uint32_t kImmData = 0x123;
+
+struct HostRegion {
+  uint64_t addr;
+  uint64_t size;
+  uint64_t key;
+};
+
+struct Message {
+  int rank;
+  size_t num;  // number of items
+  uint64_t seed;
+
+  HostRegion &operator[](int i) {
+    auto base = (HostRegion *)((char *)this + sizeof(*this));
+    return base[i];
+  }
+};
+
+static void AllGatherAddr(const char *addr, int rank, std::string &endpoints) {
+  std::memcpy(endpoints.data() + ENDPOINT_IDX(rank), addr, kMaxAddrSize);
+  MPI_Allgather(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, endpoints.data(), kMaxAddrSize, MPI_BYTE, MPI_COMM_WORLD);
+}
+
+class Peer : private NoCopy {
+ public:
+  Peer() = delete;
+  Peer(int peer, size_t page_size, size_t num_pages)
+      : net_{Net()}, peer_{peer}, page_size_{page_size}, num_pages_{num_pages}, size_{page_size * num_pages} {
+    auto &mpi = MPI::Get();
+    auto &efa = EFA::Get();
+    auto rank = mpi.GetWorldRank();
+    auto info = efa.GetEFAInfo();
+    net_.Open(info, efa.GetShmInfo());
+
+    char remote[kMaxAddrSize] = {0};
+    Connect(net_, peer, remote);
+    conn_ = net_.Connect(remote);
+    ASSERT(!!conn_);
+    auto local = net_.IsLocal(remote);
+    total_bw_ = (!local and info->nic) ? info->nic->link_attr->speed : 0;
+
+    std::cout << fmt::format("[RANK:{}] peer={} path={}", rank, peer, local ? "shm" : "efa") << std::endl;
+    std::cout << fmt::format("page_size={} num_pages={} total={} mem_size={}", page_size_, num_pages_, size_, kMemoryRegionSize) << std::endl;
+    ASSERT((page_size_ * num_pages_) <= conn_->GetReadBuffer().GetSize());
+    ASSERT((page_size_ * num_pages_) <= conn_->GetWriteBuffer().GetSize());
+  }
+
+ protected:
+  inline static void Connect(Net &net, int peer, char *remote) {
+    auto &mpi = MPI::Get();
+    int rank = mpi.GetWorldRank();
+    std::string endpoints(mpi.GetWorldSize() * kMaxAddrSize, 0);
+    AllGatherAddr(net.GetAddr(), rank, endpoints);
+    std::memcpy(remote, endpoints.data() + ENDPOINT_IDX(peer), kMaxAddrSize);
+  }
+
+  inline static std::vector<uint8_t> RandBuffer(uint64_t seed, size_t size) {
+    ASSERT(size % sizeof(uint64_t) == 0);
+    std::vector<uint8_t> buf(size);
+    std::mt19937_64 gen(seed);
+    std::uniform_int_distribution<uint64_t> dist;
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) *(uint64_t *)(buf.data() + i) = dist(gen);
+    return buf;
+  }
+
+  inline static bool Verify(char *buffer, uint64_t seed, size_t size) {
+    auto expected = RandBuffer(seed, size);
+    return std::memcmp(expected.data(), buffer, size) == 0;
+  }
+
+ protected:
+  Net net_;
+  int peer_;
+  Conn *conn_;
+  size_t page_size_;
+  size_t num_pages_;
+  size_t size_;
+  size_t total_bw_;
+  std::mt19937_64 rng_{0x123456789UL};
+};
+
+class Writer : public Peer {
+ public:
+  Writer() = delete;
+  Writer(int peer, size_t page_size, size_t num_pages) : Peer(peer, page_size, num_pages) {}
+
+  Coro<> Handshake() {
+    auto [buf, size] = co_await conn_->Recv();
+    auto resp = (Message *)buf;
+    ASSERT(MSGSIZE(resp) == size);
+    ASSERT(resp->rank == peer_);
+    peer_seed_ = resp->seed;
+    peer_regions_.resize(resp->num);
+    for (size_t i = 0; i < resp->num; ++i) {
+      peer_regions_[i] = (*resp)[i];
+    }
+
+    // fill the source pages with the data the reader expects
+    auto buffer = RandBuffer(peer_seed_, size_);
+    std::memcpy(conn_->GetWriteBuffer().GetData(), buffer.data(), size_);
+  }
+
+  Coro<> Write(size_t repeat) {
+    auto total_ops = repeat * peer_regions_.size() * num_pages_;
+    auto progress = Progress(total_ops, total_bw_);
+    size_t ops = 0;
+    for (size_t i = 0; i < repeat; ++i) {
+      co_await WriteOne(progress, ops);
+    }
+    std::cout << std::endl;
+  }
+
+  Coro<> WriteOne(Progress &progress, size_t &ops) {
+    const size_t batch_size = 8;
+    auto buffer = conn_->GetWriteBuffer().GetData();
+    std::deque<Future<Coro<size_t>>> futs;
+    for (auto &region : peer_regions_) {
+      for (size_t i = 0; i < num_pages_; ++i) {
+        while (futs.size() >= batch_size) {
+          auto &fut = futs.front();
+          co_await fut;
+          ++ops;
+          futs.pop_front();
+        }
+
+        auto base = (char *)buffer + i * page_size_;
+        auto addr = region.addr + i * page_size_;
+        auto key = region.key;
+        auto is_final = (i == num_pages_ - 1);
+        auto imm_data = is_final ? kImmData : 0;
+        futs.emplace_back(Future(conn_->Write(base, page_size_, addr, key, imm_data)));
+      }
+    }
+
+    for (auto &fut : futs) {
+      co_await fut;
+      ++ops;
+    }
+    auto now = std::chrono::high_resolution_clock::now();
+    progress.Print(now, page_size_, ops);
+  }
+
+ private:
+  uint64_t peer_seed_;
+  std::vector<HostRegion> peer_regions_;
+};
+
+class Reader : public Peer {
+ public:
+  Reader() = delete;
+  Reader(int peer, size_t page_size, size_t num_pages) : Peer(peer, page_size, num_pages) {}
+
+  Coro<> Handshake() {
+    auto req = Alloc(conn_);
+    auto size = co_await conn_->Send((char *)req, MSGSIZE(req));
+    ASSERT(size == MSGSIZE(req));
+  }
+
+  Coro<> Read(size_t repeat) {
+    for (size_t i = 0; i < repeat; ++i) {
+      co_await conn_->Read(kImmData);
+    }
+    auto buffer = (char *)conn_->GetReadBuffer().GetData();
+    ASSERT(Verify(buffer, seed_, size_));
+  }
+
+ private:
+  inline Message *Alloc(Conn *conn) {
+    auto &mpi = MPI::Get();
+    auto &buffer = conn->GetSendBuffer();
+    auto data = (Message *)buffer.GetData();
+    auto &read_buffer = conn->GetReadBuffer();
+    auto &header = *data;
+    auto &payload = (*data)[0];
+
+    seed_ = rng_();
+    header.rank = mpi.GetWorldRank();
+    header.num = 1;
+    header.seed = seed_;
+    payload.addr = (uint64_t)read_buffer.GetData();
+    payload.size = read_buffer.GetSize();
+    payload.key = read_buffer.GetMR()->key;
+    return data;
+  }
+
+ private:
+  uint64_t seed_;
+};
+
+Coro<> StartWriter(size_t page_size, size_t num_pages, size_t repeat) {
+  auto peer = 1;
+  auto writer = Writer(peer, page_size, num_pages);
+  co_await writer.Handshake();
+  co_await writer.Write(repeat);
+}
+
+Coro<> StartReader(size_t page_size, size_t num_pages, size_t repeat) {
+  auto peer = 0;
+  auto reader = Reader(peer, page_size, num_pages);
+  co_await reader.Handshake();
+  co_await reader.Read(repeat);
+}
+
+int main(int argc, char *argv[]) {
+  auto &mpi = MPI::Get();
+  // assumption: 2 ranks, either on the same node (shm) or on two nodes (efa)
+  ASSERT(mpi.GetWorldSize() == 2);
+
+  constexpr size_t page_size = 256 << 10;  // 256k
+  constexpr size_t num_pages = 250;
+  constexpr size_t repeat = 10000;
+  if (mpi.GetWorldRank() == 0) {
+    Run(StartWriter(page_size, num_pages, repeat));
+  } else {
+    Run(StartReader(page_size, num_pages, repeat));
+  }
+}
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+set -exo pipefail
+
+DIR="$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+sqsh="${DIR}/../../efa+latest.sqsh"
+mount="/fsx:/fsx"
+binary="${DIR}/../../build/src/shm/shm"
+
+# two ranks on one node go through the shm provider; use --nodes=2
+# --ntasks-per-node=1 to compare against the EFA path.
+srun --container-image "${sqsh}" \
+  --container-mounts "${mount}" \
+  --container-name efa \
+  --mpi=pmix \
+  --nodes=1 \
+  --ntasks-per-node=2 \
+  "${binary}"